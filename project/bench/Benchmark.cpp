@@ -0,0 +1,251 @@
+#include "imgclean/FileHandler.hpp"
+#include "imgclean/GSImage.hpp"
+#include "imgclean/PPMImage.hpp"
+#include "imgclean/StreamCleaner.hpp"
+#include "imgclean/processors/BackgroundProcessor.hpp"
+#include "imgclean/processors/ClaheProcessor.hpp"
+#include "imgclean/processors/DespeckleProcessor.hpp"
+#include "imgclean/processors/GaussianProcessor.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/ImageBinarizationProcessor.hpp"
+#include "imgclean/processors/IntegralImageProcessor.hpp"
+#include "imgclean/processors/MedianProcessor.hpp"
+#include "imgclean/processors/OtsuProcessor.hpp"
+#include "imgclean/processors/SauvolaProcessor.hpp"
+#include "imgclean/processors/WolfProcessor.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using imgclean::processors::WindowEngine;
+
+//! Synthetic RGB page: shaded paper with rows of dark strokes
+static imgclean::PPMImage make_page(int width, int height)
+{
+	imgclean::PPMImage page;
+	page.width  = width;
+	page.height = height;
+	page.pixels.resize(page.pixel_count() * 3);
+
+	uint32_t state = 1;
+	for (size_t y = 0; y < static_cast<size_t>(height); ++y)
+	{
+		for (size_t x = 0; x < static_cast<size_t>(width); ++x)
+		{
+			state          = state * 1664525u + 1013904223u;
+			int value      = 180 + static_cast<int>((50 * x) / width) + static_cast<int>((state >> 16) % 15);
+			const bool ink = (y % 40) >= 10 && (y % 40) < 30 && (x % 13) < 4;
+			if (ink) value = 50;
+			const size_t idx     = (y * width + x) * 3;
+			page.pixels[idx + 0] = static_cast<uint16_t>(std::min(value, 255));
+			page.pixels[idx + 1] = static_cast<uint16_t>(std::min(value + 3, 255));
+			page.pixels[idx + 2] = static_cast<uint16_t>(std::min(value - 5, 255));
+		}
+	}
+	return page;
+}
+
+//! Runs fn repeats times and prints the best wall time and the throughput
+template <typename Fn>
+static void run(const std::string& name, size_t num_pixels, int repeats, Fn fn)
+{
+	double best_ms = 0.0;
+	for (int r = 0; r < repeats; ++r)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		fn();
+		const auto end  = std::chrono::high_resolution_clock::now();
+		const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		if (r == 0 || ms < best_ms) best_ms = ms;
+	}
+	std::cout << std::left << std::setw(36) << name << std::right << std::setw(10) << std::fixed
+	          << std::setprecision(2) << best_ms << " ms" << std::setw(10) << std::setprecision(1)
+	          << static_cast<double>(num_pixels) / (best_ms * 1e3) << " MP/s\n";
+}
+
+//! Prints the share of pixels in which an approximate result differs from the exact one
+static void report_quality(const imgclean::BinaryImage& exact, const imgclean::BinaryImage& approximate)
+{
+	size_t differences = 0;
+	for (size_t k = 0; k < exact.words.size(); ++k)
+	{
+		differences += std::popcount(exact.words[k] ^ approximate.words[k]);
+	}
+	std::cout << "  differs from exact in " << std::setprecision(3)
+	          << 100.0 * static_cast<double>(differences) / static_cast<double>(exact.pixel_count())
+	          << " % of the pixels\n";
+}
+
+int main(int argc, char** argv)
+{
+	// default: A4 page scanned at 300 dpi
+	const int width   = argc > 1 ? std::atoi(argv[1]) : 2480;
+	const int height  = argc > 2 ? std::atoi(argv[2]) : 3508;
+	const int repeats = argc > 3 ? std::atoi(argv[3]) : 5;
+	if (width <= 0 || height <= 0 || repeats <= 0)
+	{
+		std::cerr << "Usage: " << argv[0] << " [width] [height] [repeats]\n";
+		return EXIT_FAILURE;
+	}
+
+	const imgclean::PPMImage page = make_page(width, height);
+	const size_t num_pixels       = page.pixel_count();
+	std::cout << "Image: " << width << " x " << height << " (" << num_pixels / 1e6 << " MP), best of " << repeats
+	          << " runs\n";
+
+	imgclean::GSImage gray;
+	run("rgb_to_linear_grayscale", num_pixels, repeats,
+	    [&] { gray = imgclean::processors::HelperProcessor::rgb_to_linear_grayscale(page); });
+	run("grayscale_to_rgb", num_pixels, repeats,
+	    [&] { imgclean::processors::HelperProcessor::grayscale_to_rgb(gray); });
+	run("integral (integral image)", num_pixels, repeats,
+	    [&] { imgclean::processors::IntegralImageProcessor::apply(gray, WindowEngine::INTEGRAL_IMAGE); });
+	run("integral (sliding window)", num_pixels, repeats,
+	    [&] { imgclean::processors::IntegralImageProcessor::apply(gray, WindowEngine::SLIDING_WINDOW); });
+	run("adaptive (integral image)", num_pixels, repeats,
+	    [&] { imgclean::processors::ImageBinarizationProcessor::apply(gray, WindowEngine::INTEGRAL_IMAGE); });
+	run("adaptive (sliding window)", num_pixels, repeats,
+	    [&] { imgclean::processors::ImageBinarizationProcessor::apply(gray, WindowEngine::SLIDING_WINDOW); });
+	run("otsu histogram", num_pixels, repeats, [&] { imgclean::processors::OtsuProcessor::histogram(gray); });
+	run("otsu", num_pixels, repeats, [&] { imgclean::processors::OtsuProcessor::apply(gray); });
+	run("otsu bit-packed", num_pixels, repeats, [&] { imgclean::processors::OtsuProcessor::apply_binary(gray); });
+	run("sauvola (integral image)", num_pixels, repeats,
+	    [&] { imgclean::processors::SauvolaProcessor::apply_binary(gray, WindowEngine::INTEGRAL_IMAGE); });
+	run("sauvola (sliding window)", num_pixels, repeats,
+	    [&] { imgclean::processors::SauvolaProcessor::apply_binary(gray, WindowEngine::SLIDING_WINDOW); });
+	run("wolf (sliding window)", num_pixels, repeats,
+	    [&] { imgclean::processors::WolfProcessor::apply_binary(gray, WindowEngine::SLIDING_WINDOW); });
+	run("integral bit-packed (sliding window)", num_pixels, repeats,
+	    [&] { imgclean::processors::IntegralImageProcessor::apply_binary(gray, WindowEngine::SLIDING_WINDOW); });
+	// separate stages from the RGB page vs. the fused row-strip execution
+	run("gray + sauvola (separate)", num_pixels, repeats,
+	    [&]
+	    {
+		    using namespace imgclean::processors;
+		    SauvolaProcessor::apply_binary(HelperProcessor::rgb_to_linear_grayscale(page),
+		                                   WindowEngine::SLIDING_WINDOW);
+	    });
+	run("gray + sauvola (fused)", num_pixels, repeats,
+	    [&] { imgclean::processors::SauvolaProcessor::apply_rgb(page); });
+	run("gray + integral (separate)", num_pixels, repeats,
+	    [&]
+	    {
+		    using namespace imgclean::processors;
+		    IntegralImageProcessor::apply_binary(HelperProcessor::rgb_to_linear_grayscale(page),
+		                                         WindowEngine::SLIDING_WINDOW);
+	    });
+	run("gray + integral (fused)", num_pixels, repeats,
+	    [&] { imgclean::processors::IntegralImageProcessor::apply_rgb(page); });
+	// rows pushed one at a time as from a scanner, on the calling thread only
+	{
+		auto discard = [](int, const uint64_t*) {};
+		imgclean::StreamCleaner cleaner;
+		if (imgclean::StreamCleaner::create("sauvola", imgclean::CleanOptions(), width, discard, cleaner))
+		{
+			const uint16_t scale = imgclean::processors::HelperProcessor::max_luma(page);
+			run("gray + sauvola (streamed rows)", num_pixels, repeats,
+			    [&]
+			    {
+				    for (int y = 0; y < height; ++y)
+				    {
+					    cleaner.push_rows(page.pixels.data() + static_cast<size_t>(y) * width * 3, 1, scale);
+				    }
+				    cleaner.finish();
+			    });
+		}
+		else
+		{
+			std::cerr << "gray + sauvola (streamed rows) skipped, the stream could not be created\n";
+		}
+	}
+	for (int window : {31, 63, 45})
+	{
+		using imgclean::processors::IntegralImageProcessor;
+		run("integral bit-packed w=" + std::to_string(window) + " (sliding)", num_pixels, repeats,
+		    [&] { IntegralImageProcessor::apply_binary(gray, WindowEngine::SLIDING_WINDOW, window); });
+	}
+
+	// the van Herk/Gil-Werman closing costs the same for every window size
+	for (int window : {51, 201, 401})
+	{
+		run("background w=" + std::to_string(window), num_pixels, repeats,
+		    [&] { imgclean::processors::BackgroundProcessor::apply(gray, window); });
+	}
+
+	run("clahe 8x8", num_pixels, repeats, [&] { imgclean::processors::ClaheProcessor::apply(gray); });
+
+	// three stacked box passes, the cost does not grow with sigma
+	for (float sigma : {1.0f, 3.0f, 10.0f})
+	{
+		run("gaussian s=" + std::to_string(static_cast<int>(sigma)), num_pixels, repeats,
+		    [&] { imgclean::processors::GaussianProcessor::apply(gray, sigma); });
+	}
+
+	// the histogram median costs the same for every window size
+	for (int window : {3, 15, 51})
+	{
+		run("median w=" + std::to_string(window), num_pixels, repeats,
+		    [&] { imgclean::processors::MedianProcessor::apply(gray, window); });
+	}
+
+	// connected components of a noisy page, the components are labeled on runs of ink
+	{
+		using namespace imgclean::processors;
+		const auto binary = SauvolaProcessor::apply_binary(gray, WindowEngine::SLIDING_WINDOW);
+		run("despeckle a=8", num_pixels, repeats, [&] { DespeckleProcessor::apply(binary, 8); });
+	}
+
+	// approximate threshold surface: speed and quality per grid factor, the sliding engine is the faster one
+	for (int window : {15, 63})
+	{
+		using namespace imgclean::processors;
+		using Integral           = IntegralImageProcessor;
+		using Adaptive           = ImageBinarizationProcessor;
+		const std::string suffix = " w=" + std::to_string(window);
+		const auto engine        = WindowEngine::SLIDING_WINDOW;
+		const auto exact_mean    = IntegralImageProcessor::apply_binary(gray, engine, window);
+		const auto exact_page    = ImageBinarizationProcessor::apply_binary(gray, engine, window);
+		run("integral" + suffix + " exact", num_pixels, repeats,
+		    [&] { IntegralImageProcessor::apply_binary(gray, engine, window); });
+		for (int factor : {2, 4, 8})
+		{
+			imgclean::BinaryImage result;
+			run("integral" + suffix + " grid x" + std::to_string(factor), num_pixels, repeats,
+			    [&] { result = Integral::apply_approximate(gray, engine, window, 0.85f, factor); });
+			report_quality(exact_mean, result);
+		}
+		run("adaptive" + suffix + " exact", num_pixels, repeats,
+		    [&] { ImageBinarizationProcessor::apply_binary(gray, engine, window); });
+		for (int factor : {2, 4, 8})
+		{
+			imgclean::BinaryImage result;
+			run("adaptive" + suffix + " grid x" + std::to_string(factor), num_pixels, repeats,
+			    [&] { result = Adaptive::apply_approximate(gray, engine, window, factor); });
+			report_quality(exact_page, result);
+		}
+	}
+
+	// file formats: the ASCII P3 text against the raw P6 bytes of the same page
+	{
+		using imgclean::FileHandler;
+		using imgclean::ImageFormat;
+		const std::filesystem::path dir = std::filesystem::temp_directory_path();
+		const imgclean::FilePath ascii{(dir / "imgclean_bench_p3.ppm").string(), ImageFormat::PPM_ASCII};
+		const imgclean::FilePath binary{(dir / "imgclean_bench_p6.ppm").string(), ImageFormat::PPM_BINARY};
+		imgclean::PPMImage loaded;
+		run("save P3", num_pixels, repeats, [&] { FileHandler::save_image(ascii, page); });
+		run("save P6", num_pixels, repeats, [&] { FileHandler::save_image(binary, page); });
+		run("load P3", num_pixels, repeats, [&] { FileHandler::load_image(ascii, loaded); });
+		run("load P6", num_pixels, repeats, [&] { FileHandler::load_image(binary, loaded); });
+		std::filesystem::remove(ascii.path);
+		std::filesystem::remove(binary.path);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -1,4 +1,4 @@
 mkdir -p build
 cd build
-cmake -DCMAKE_CXX_COMPILER=g++-15 -DCMAKE_BUILD_TYPE=Release -DMEASURE_PERFORMANCE=ON ..
+cmake -DCMAKE_CXX_COMPILER=g++-15 -DCMAKE_BUILD_TYPE=Release -DMEASURE_PERFORMANCE=ON -DENABLE_NATIVE_ARCH=ON ..
 cmake --build . --parallel 11
\ No newline at end of file
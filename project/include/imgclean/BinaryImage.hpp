@@ -0,0 +1,82 @@
+#ifndef IMGCLEAN_BINARYIMAGE_HPP
+#define IMGCLEAN_BINARYIMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace imgclean
+{
+
+//! Struct to store a bi-level image with 1 bit per pixel
+//! A set bit is ink (black), a cleared bit is background (white).
+//! Pixel x of a row lives in bit x % 64 of word x / 64 (LSB first), every row starts at a new word
+//! and the unused bits at the end of a row are always zero, so rows can be processed word by word.
+struct BinaryImage
+{
+	int width  = 0;
+	int height = 0;
+	size_t words_per_row = 0;
+	std::vector<uint64_t> words; // size = words_per_row * height
+	std::vector<unsigned char> exif_data; // EXIF segment for JPG
+
+	//! Number of pixels stored per word
+	static constexpr int word_bits = 64;
+
+	//! Number of words needed for one row of the given width
+	static size_t row_words(int width) { return (static_cast<size_t>(width) + word_bits - 1) / word_bits; }
+
+	bool empty() const { return width <= 0 || height <= 0 || words.empty(); }
+	//! Number of pixels, computed in 64 bits so that it does not overflow for very large images
+	size_t pixel_count() const { return static_cast<size_t>(width) * static_cast<size_t>(height); }
+
+	//! Sets the size and clears all pixels to background
+	void resize(int new_width, int new_height)
+	{
+		width         = new_width;
+		height        = new_height;
+		words_per_row = row_words(new_width);
+		words.assign(words_per_row * static_cast<size_t>(new_height), 0);
+	}
+
+	uint64_t* row(int y) { return words.data() + static_cast<size_t>(y) * words_per_row; }
+	const uint64_t* row(int y) const { return words.data() + static_cast<size_t>(y) * words_per_row; }
+
+	//! True if pixel (x, y) is ink
+	bool get(int x, int y) const { return (row(y)[x / word_bits] >> (x % word_bits)) & 1u; }
+	void set(int x, int y, bool ink)
+	{
+		const uint64_t mask = uint64_t(1) << (x % word_bits);
+		uint64_t& word      = row(y)[x / word_bits];
+		word                = ink ? (word | mask) : (word & ~mask);
+	}
+
+	void clear()
+	{
+		words.clear();
+		exif_data.clear();
+		width         = 0;
+		height        = 0;
+		words_per_row = 0;
+	}
+
+	//! Packs one row: bit i of the row is set iff is_ink(i), evaluated 64 pixels per output word
+	template <typename Predicate>
+	static void pack_row(uint64_t* dst, int width, Predicate is_ink)
+	{
+		for (int x0 = 0; x0 < width; x0 += word_bits)
+		{
+			const int count = width - x0 < word_bits ? width - x0 : word_bits;
+			uint64_t word   = 0;
+			for (int b = 0; b < count; ++b)
+			{
+				word |= static_cast<uint64_t>(is_ink(x0 + b) ? 1u : 0u) << b;
+			}
+			dst[x0 / word_bits] = word;
+		}
+	}
+};
+
+} // namespace imgclean
+
+#endif // IMGCLEAN_BINARYIMAGE_HPP
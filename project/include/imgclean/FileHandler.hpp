@@ -2,6 +2,7 @@
 #define IMGCLEAN_FILEHANDLER_HPP
 
 #include "imgclean/FilePath.hpp"
+#include "imgclean/GSImage.hpp"
 #include "imgclean/ImageFormat.hpp"
 #include "imgclean/PPMImage.hpp"
 #include <string>
@@ -13,19 +14,31 @@ class FileHandler
 {
 public:
 
-	//! Detect format from file extension (e.g. .ppm, .png, .jpg, .jpeg)
+	//! Detect format from file extension (e.g. .ppm, .pgm, .pnm, .png, .jpg, .jpeg)
+	//! Only the extension counts, so a file already at an output path does not change the format written:
+	//! P3 for .ppm, P5 for .pgm and P6 for .pnm
 	static ImageFormat detect_format(const std::string& path);
 
 	//! Convenience to build a FilePath with detected format
-	static FilePath make_file_path(const std::string& path);
+	//! plain = true selects the plain text netpbm variants, P2 instead of P5 and P3 instead of P6
+	//! binary = true selects P6 instead of P3 for .ppm, plain takes precedence
+	static FilePath make_file_path(const std::string& path, bool plain = false, bool binary = false);
 
 	//! Loads an image into PPM
-	//! The file type is inferred from src file ending
+	//! The file type is inferred from src file ending, for netpbm files the magic number picks P3, P5 or P6
+	//! P3, P5 and P6 files are memory-mapped and converted straight from the mapped bytes, 16-bit samples
+	//! (maxval above 255) are big-endian. P5 gray values are repeated for R, G and B
 	static bool load_image(const FilePath& src, PPMImage& out);
 
 	//! Saves an image from PPM
 	//! The file type is inferred from dst file ending
+	//! P6 samples take two big-endian bytes if maxval is above 255
 	static bool save_image(const FilePath& dst, const PPMImage& img);
+
+	//! Saves a single-channel image without expanding it to RGB
+	//! PGM (P2/P5), grayscale PNG and grayscale JPG are written natively, P3 and P6 repeat the gray value
+	//! P2 lines are wrapped after 17 values, so that they stay within 70 characters
+	static bool save_image(const FilePath& dst, const GSImage& img);
 };
 } // namespace imgclean
 
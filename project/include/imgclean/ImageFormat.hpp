@@ -7,7 +7,10 @@ namespace imgclean
 //! Supported image formats
 enum class ImageFormat
 {
-	PPM_ASCII, // P3
+	PPM_ASCII,  // P3
+	PPM_BINARY, // P6
+	PGM_ASCII,  // P2
+	PGM_BINARY, // P5
 	PNG,
 	JPG,
 	UNKNOWN
@@ -2,19 +2,47 @@
 #define IMGCLEAN_HPP
 
 #include "ImageFormat.hpp"
+#include "Pipeline.hpp"
 #include <string>
 
 namespace imgclean
 {
 
+//! Tuning parameters of the cleaning approaches
+struct CleanOptions
+{
+	//! Side length of the local window, must be odd
+	int window_size = 15;
+	//! Fraction of the local mean below which a pixel becomes ink ('integral' approach only)
+	float threshold = 0.85f;
+	//! Grid factor of the approximate threshold surface, 1 is exact ('integral' and 'adaptive' only)
+	int grid_factor = 1;
+	//! Run the gray conversion fused with the thresholding, see Pipeline
+	bool fused = false;
+	//! Write netpbm output as plain text, P2 for .pgm and P3 for .pnm, see FileHandler::make_file_path
+	bool plain = false;
+	//! Write .ppm output as binary P6 instead of plain text P3, see FileHandler::make_file_path
+	bool binary = false;
+};
+
 class ImgClean
 {
 public:
 	//! Check if the required format support is available based on compile-time definitions
 	static bool check_format_support(const imgclean::ImageFormat& format, const std::string& path);
 
-	//! Clean the image at input_path and save the result to output_path
-	static bool clean_image(const std::string& input_path, const std::string& output_path, const std::string& approach);
+	//! Clean the image at input_path with a registered thresholding stage and save the result to output_path
+	static bool clean_image(const std::string& input_path, const std::string& output_path,
+	                        const std::string& approach, const CleanOptions& options = CleanOptions());
+
+	//! Run the pipeline on the image at input_path and save the result to output_path,
+	//! plain = true writes netpbm output as plain text, binary = true writes .ppm output as P6
+	static bool clean_image(const std::string& input_path, const std::string& output_path,
+	                        const Pipeline& pipeline, bool plain = false, bool binary = false);
+
+	//! Pipeline of the approach, e.g. "gray|sauvola:w=15", options are only passed where the stage declares them.
+	//! Prints the reason and returns false if approach is not a GRAY8 to BINARY stage or an option is invalid.
+	static bool approach_pipeline(const std::string& approach, const CleanOptions& options, Pipeline& pipeline);
 };
 } // namespace imgclean
 
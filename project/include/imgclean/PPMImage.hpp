@@ -1,6 +1,7 @@
 #ifndef IMGCLEAN_PPMIMAGE_HPP
 #define IMGCLEAN_PPMIMAGE_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -17,6 +18,8 @@ struct PPMImage
 	std::vector<unsigned char> exif_data; // EXIF segment for JPG
 
 	bool empty() const { return width <= 0 || height <= 0 || pixels.empty(); }
+	//! Number of pixels, computed in 64 bits so that it does not overflow for very large images
+	size_t pixel_count() const { return static_cast<size_t>(width) * static_cast<size_t>(height); }
 	void clear()
 	{
 		pixels.clear();
@@ -0,0 +1,98 @@
+#ifndef IMGCLEAN_PIPELINE_HPP
+#define IMGCLEAN_PIPELINE_HPP
+
+#include "BinaryImage.hpp"
+#include "GSImage.hpp"
+#include "PPMImage.hpp"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace imgclean
+{
+
+//! Pixel representation a pipeline stage reads or writes
+enum class PixelType
+{
+	RGB16,  // PPMImage
+	GRAY8,  // GSImage
+	BINARY  // BinaryImage
+};
+
+//! Name of a pixel type for messages
+const char* to_string(PixelType type);
+
+//! One buffer slot of a pipeline, holds one image per pixel type.
+//! A stage reads the member of its input type and writes the member of its output type.
+struct ImageBuffer
+{
+	PPMImage rgb;
+	GSImage gray;
+	BinaryImage binary;
+
+	//! Frees the image of the given type
+	void release(PixelType type);
+};
+
+//! Parameter values of a stage by parameter name
+using ParameterValues = std::map<std::string, double>;
+
+//! Runs a configured stage: reads in, writes out
+using StageFunction = std::function<void(const ImageBuffer& in, ImageBuffer& out)>;
+
+//! Chain of processing stages, e.g. "gray|median3|sauvola:w=31|despeckle:8".
+//! Stages are separated by '|'. A stage is a registered name followed by optional ':' and comma-separated
+//! arguments, either positional in the declared parameter order or as key=value. A name ending in digits
+//! that is not registered itself is shorthand for its first positional argument (median3 = median:3).
+//! The pipeline takes an RGB16 image. Input types are checked when parsing, a missing conversion to GRAY8
+//! ("gray" after the RGB16 input, "expand" after a BINARY stage) is inserted automatically.
+//! Buffer slots are planned once when parsing: a stage that keeps the pixel type writes into the other of
+//! two slots, every other stage writes next to its input in the same slot. The input of a stage is freed
+//! as soon as the stage ran, so a run holds at most one input and one output image at a time.
+//! Fusion (optional): a stage registered with a fused variant that directly follows "gray" reads the RGB16
+//! input itself and streams row strips through the conversion and its own kernel, "gray" is then skipped
+//! and no full-frame gray image is written. Fused and separate execution give identical results.
+class Pipeline
+{
+public:
+	//! A stage with its parameters and planned buffer slots
+	struct Stage
+	{
+		std::string name;
+		ParameterValues values;
+		PixelType input  = PixelType::RGB16;
+		PixelType output = PixelType::RGB16;
+		StageFunction run;
+		int input_slot  = 0;
+		int output_slot = 0;
+		//! Runs as part of the next stage, which reads the input of this stage
+		bool fused = false;
+	};
+
+	//! Parses a pipeline description, prints the reason to std::cerr and returns false if it is invalid.
+	//! fuse = true runs "gray" fused with the following stage where possible. It saves the full-frame gray
+	//! image and its memory traffic, but reads the RGB input twice (the rescale needs the maximum first).
+	static bool parse(const std::string& spec, Pipeline& pipeline, bool fuse = false);
+
+	//! Runs all stages on the image, a BINARY result is expanded to 0/255 gray values
+	bool run(PPMImage input, GSImage& output) const;
+
+	//! Canonical description of the planned stages with all parameter values
+	std::string describe() const;
+
+	const std::vector<Stage>& stages() const { return stage_list; }
+
+private:
+	//! Appends a stage and plans its slots, inserts the implicit conversion to its input type if needed.
+	//! Prints the reason to std::cerr and returns false if the input type cannot be reached.
+	bool push(Stage stage, bool fuse);
+
+	std::vector<Stage> stage_list;
+	//! Buffer slots, reused by every run
+	mutable std::vector<ImageBuffer> slots;
+};
+
+} // namespace imgclean
+
+#endif // IMGCLEAN_PIPELINE_HPP
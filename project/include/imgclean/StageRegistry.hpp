@@ -0,0 +1,62 @@
+#ifndef IMGCLEAN_STAGEREGISTRY_HPP
+#define IMGCLEAN_STAGEREGISTRY_HPP
+
+#include "Pipeline.hpp"
+#include "processors/ThresholdStream.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace imgclean
+{
+
+//! Declared parameter of a stage
+struct StageParameter
+{
+	enum class Kind
+	{
+		REAL,
+		INTEGER,
+		WINDOW // odd integer, see processors::is_valid_window_size
+	};
+
+	std::string name;
+	Kind kind            = Kind::REAL;
+	double default_value = 0.0;
+	double min_value     = 0.0;
+	double max_value     = 0.0;
+};
+
+//! Registered stage: pixel types, parameters in positional order and a factory for the configured stage
+struct StageDefinition
+{
+	std::string name;
+	std::string description;
+	PixelType input  = PixelType::GRAY8;
+	PixelType output = PixelType::GRAY8;
+	std::vector<StageParameter> parameters = {};
+	//! Creates the stage for a complete and validated set of parameter values
+	std::function<StageFunction(const ParameterValues&)> make = {};
+	//! Optional: creates the stage fused with a preceding "gray", it reads the RGB16 input of "gray" directly
+	std::function<StageFunction(const ParameterValues&)> make_fused = {};
+	//! Optional: creates the stage for rows of the given width that are pushed one at a time, see StreamCleaner
+	std::function<processors::ThresholdStream(int width, const ParameterValues&)> make_stream = {};
+};
+
+//! Processors available to pipelines, by name
+class StageRegistry
+{
+public:
+	//! Stage with the given name, nullptr if there is none
+	static const StageDefinition* find(const std::string& name);
+
+	//! All stages in registration order
+	static const std::vector<StageDefinition>& all();
+
+	//! Names of the stages converting from input to output, e.g. all thresholding methods, separated by ", "
+	static std::string names(PixelType input, PixelType output);
+};
+
+} // namespace imgclean
+
+#endif // IMGCLEAN_STAGEREGISTRY_HPP
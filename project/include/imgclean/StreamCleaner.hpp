@@ -0,0 +1,60 @@
+#ifndef IMGCLEAN_STREAMCLEANER_HPP
+#define IMGCLEAN_STREAMCLEANER_HPP
+
+#include "ImgClean.hpp"
+#include "Pipeline.hpp"
+#include "processors/ThresholdStream.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace imgclean
+{
+
+//! Push-based cleaner for pages that arrive row by row, e.g. from a sheet-fed scanner, so that cleaning
+//! overlaps with scanning instead of waiting for a file. Rows are pushed with push_rows() and every binarized
+//! row is handed to the sink as soon as the rows below it arrived, half_window rows later (see latency()).
+//! finish() emits the last rows of a page, the next pushed row starts a new page.
+//! Only windowed thresholding stages that register a row stream can run this way ("integral" with g = 1,
+//! "niblack" and "sauvola"), stages that need the whole page, like "otsu", "wolf" or "despeckle", cannot.
+class StreamCleaner
+{
+public:
+	//! Receives row y of the page, bit-packed like a row of a BinaryImage (set bits are ink)
+	using RowSink = processors::ThresholdStream::RowSink;
+
+	//! Sets up the cleaner for rows of the given width, the pipeline is a streamable thresholding stage after an
+	//! optional "gray", e.g. "sauvola:w=31". Prints the reason to std::cerr and returns false otherwise.
+	static bool create(const Pipeline& pipeline, int width, RowSink sink, StreamCleaner& cleaner);
+
+	//! Same as create with the pipeline of ImgClean::approach_pipeline
+	static bool create(const std::string& approach, const CleanOptions& options, int width, RowSink sink,
+	                   StreamCleaner& cleaner);
+
+	//! Adds count rows of interleaved RGB samples, count * width * 3 values. The gray conversion maps max_luma
+	//! to 255 like rgb_to_linear_grayscale: the result equals the pipeline on the whole page if max_luma is
+	//! HelperProcessor::max_luma of the page, the white level of the scanner is the usual choice while streaming.
+	//! Brighter samples are clamped to max_luma.
+	void push_rows(const uint16_t* rgb, int count, uint16_t max_luma = 255);
+
+	//! Adds count rows of gray pixels, count * width values, they are thresholded as they are
+	void push_rows(const uint8_t* gray, int count);
+
+	//! Emits the rows of the page that are still waiting for the rows below them
+	void finish();
+
+	int width() const { return stream.width(); }
+
+	//! Rows between a pushed row and the row emitted with it, half the window size
+	int latency() const { return stream.latency(); }
+
+private:
+	processors::ThresholdStream stream;
+	RowSink sink;
+	//! Gray conversion of the current RGB row
+	std::vector<uint8_t> gray_row;
+};
+
+} // namespace imgclean
+
+#endif // IMGCLEAN_STREAMCLEANER_HPP
@@ -0,0 +1,39 @@
+#ifndef IMG_CLEAN_PROCESSORS_BACKGROUNDPROCESSOR_HPP
+#define IMG_CLEAN_PROCESSORS_BACKGROUNDPROCESSOR_HPP
+
+#include <imgclean/GSImage.hpp>
+#include <cstdint>
+
+namespace imgclean::processors
+{
+//! Shading correction: estimates the paper background with a grayscale closing (max filter followed by a
+//! min filter) over a large square window and divides the image by it. Text darker and thinner than the
+//! window disappears from the background, so illumination gradients are flattened before thresholding.
+//! The filters use the van Herk/Gil-Werman algorithm: about 3 comparisons per pixel and direction,
+//! independent of the window size.
+class BackgroundProcessor
+{
+public:
+	//! Default window, wider than the strokes of body text at 300 dpi
+	static constexpr int default_window_size = 51;
+
+	//! Divides the image by its background, background pixels become 255.
+	//! window_size must be odd (see is_valid_window_size), otherwise an empty image is returned
+	static GSImage apply(const GSImage& image, int window_size = default_window_size);
+
+	//! Background estimate, the closing of the image over a window_size x window_size window
+	static GSImage estimate(const GSImage& image, int window_size = default_window_size);
+
+	//! Maximum over the window_size x window_size window around every pixel (dilation)
+	static GSImage max_filter(const GSImage& image, int window_size);
+
+	//! Minimum over the window_size x window_size window around every pixel (erosion)
+	static GSImage min_filter(const GSImage& image, int window_size);
+
+private:
+	//! Columns per parallel work item of the vertical pass, filtered side by side as row vectors
+	static constexpr int strip_columns = 256;
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_BACKGROUNDPROCESSOR_HPP
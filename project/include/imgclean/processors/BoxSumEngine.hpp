@@ -0,0 +1,181 @@
+#ifndef IMG_CLEAN_PROCESSORS_BOXSUMENGINE_HPP
+#define IMG_CLEAN_PROCESSORS_BOXSUMENGINE_HPP
+
+#include <imgclean/GSImage.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace imgclean::processors
+{
+//! How the window processors obtain their box sums
+enum class WindowEngine
+{
+	INTEGRAL_IMAGE, // full-frame summed-area table
+	SLIDING_WINDOW  // rolling column sums, see BoxSumEngine
+};
+
+//! Sliding-window box sums without a full-frame integral image.
+//! Keeps one sum (and optionally one sum of squares) per column over the rows of the current band.
+//! Rows are added at the bottom and removed at the top as the window moves down,
+//! a horizontal sliding sum over the column sums then yields the window sum of every pixel in the row.
+class BoxSumEngine
+{
+public:
+	BoxSumEngine(int width, int half_window, bool squares);
+
+	//! Adds an image row to the bottom of the band
+	void add_row(const uint8_t* row);
+
+	//! Removes an image row from the top of the band
+	void remove_row(const uint8_t* row);
+
+	//! Clears the column sums, the band is empty afterwards
+	void reset();
+
+	//! Number of rows currently in the band
+	int rows() const { return band_rows; }
+
+	//! Window sums, sums of squares (if enabled) and pixel counts for every column of the current band.
+	//! Half > 0 fixes the half window at compile time, it must then equal the runtime half_window.
+	template <int Half = 0>
+	void row_sums(uint32_t* sums, uint64_t* sums_sq, uint32_t* counts) const
+	{
+		if (sums_sq)
+			slide<Half, true>(sums, sums_sq, counts);
+		else
+			slide<Half, false>(sums, sums_sq, counts);
+	}
+
+	//! Runs the engine over a whole image and calls fn(y, sums, sums_sq, counts) once per row.
+	//! Row bands are processed in parallel, every thread keeps its own column sums.
+	//! sums_sq is nullptr if squares is false. Half is passed on to row_sums.
+	//! row_step > 1 only computes the sums of every row_step-th row and of the last row.
+	template <int Half = 0, typename RowFn>
+	static void for_each_row(const GSImage& image, int half_window, bool squares, RowFn fn, int row_step = 1)
+	{
+		const int width  = image.width;
+		const int height = image.height;
+		// each band pays half_window rows of warm-up, so bands are kept well above the window size
+		const int band      = std::max(128, 8 * (2 * half_window + 1));
+		const int num_bands = (height + band - 1) / band;
+
+		auto row_ptr = [&](int y) { return image.pixels.data() + static_cast<size_t>(y) * width; };
+
+#pragma omp parallel
+		{
+			BoxSumEngine engine(width, half_window, squares);
+			std::vector<uint32_t> sums(width);
+			std::vector<uint64_t> sums_sq(squares ? width : 0);
+			std::vector<uint32_t> counts(width);
+
+#pragma omp for schedule(static)
+			for (int b = 0; b < num_bands; ++b)
+			{
+				const int y_begin = b * band;
+				const int y_end   = std::min(height, y_begin + band);
+
+				engine.reset();
+				// rows [y_begin - half_window, y_begin + half_window - 1], the loop adds the last one
+				const int warmup_end = std::min(height, y_begin + half_window);
+				for (int y = std::max(0, y_begin - half_window); y < warmup_end; ++y)
+				{
+					engine.add_row(row_ptr(y));
+				}
+
+				for (int y = y_begin; y < y_end; ++y)
+				{
+					if (y + half_window < height) engine.add_row(row_ptr(y + half_window));
+					if (y > y_begin && y - half_window - 1 >= 0)
+					{
+						engine.remove_row(row_ptr(y - half_window - 1));
+					}
+					if (y % row_step != 0 && y != height - 1) continue;
+
+					uint64_t* sums_sq_ptr = squares ? sums_sq.data() : nullptr;
+					engine.row_sums<Half>(sums.data(), sums_sq_ptr, counts.data());
+					fn(y, sums.data(), sums_sq_ptr, counts.data());
+				}
+			}
+		}
+	}
+
+private:
+	//! Horizontal sliding sum over the column sums.
+	//! Columns whose window lies inside the row take a branch-free path with a constant pixel count.
+	template <int Half, bool Squares>
+	void slide(uint32_t* sums, uint64_t* sums_sq, uint32_t* counts) const
+	{
+		const int half         = Half > 0 ? Half : half_window;
+		const uint32_t* col    = col_sum.data();
+		const uint32_t* col_sq = col_sum_sq.data();
+		uint32_t acc           = 0;
+		uint64_t acc_sq        = 0;
+
+		//! One step of the window at the image border, where it is clipped on either side
+		auto border_step = [&](int x)
+		{
+			const int x_in  = x + half;
+			const int x_out = x - half - 1;
+			if (x_in < width)
+			{
+				acc += col[x_in];
+				if constexpr (Squares) acc_sq += col_sq[x_in];
+			}
+			if (x_out >= 0)
+			{
+				acc -= col[x_out];
+				if constexpr (Squares) acc_sq -= col_sq[x_out];
+			}
+
+			const int x1 = std::max(0, x - half);
+			const int x2 = std::min(width - 1, x + half);
+			sums[x]      = acc;
+			counts[x]    = static_cast<uint32_t>((x2 - x1 + 1) * band_rows);
+			if constexpr (Squares) sums_sq[x] = acc_sq;
+		};
+
+		// window of column 0 before the first step: columns [0, half - 1]
+		for (int x = 0; x < std::min(width, half); ++x)
+		{
+			acc += col[x];
+			if constexpr (Squares) acc_sq += col_sq[x];
+		}
+
+		const int interior_begin      = std::min(width, half + 1);
+		const int interior_end        = std::max(interior_begin, width - half);
+		const uint32_t interior_count = static_cast<uint32_t>((2 * half + 1) * band_rows);
+
+		for (int x = 0; x < interior_begin; ++x)
+		{
+			border_step(x);
+		}
+		for (int x = interior_begin; x < interior_end; ++x)
+		{
+			acc += col[x + half] - col[x - half - 1];
+			sums[x]   = acc;
+			counts[x] = interior_count;
+			if constexpr (Squares)
+			{
+				acc_sq += static_cast<uint64_t>(col_sq[x + half]) - col_sq[x - half - 1];
+				sums_sq[x] = acc_sq;
+			}
+		}
+		for (int x = interior_end; x < width; ++x)
+		{
+			border_step(x);
+		}
+	}
+
+	int width       = 0;
+	int half_window = 0;
+	int band_rows   = 0;
+	bool squares    = false;
+	//! Sum of the pixels in each column over the rows of the band
+	std::vector<uint32_t> col_sum;
+	//! Sum of the squared pixels in each column over the rows of the band
+	std::vector<uint32_t> col_sum_sq;
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_BOXSUMENGINE_HPP
@@ -0,0 +1,37 @@
+#ifndef IMG_CLEAN_PROCESSORS_CLAHEPROCESSOR_HPP
+#define IMG_CLEAN_PROCESSORS_CLAHEPROCESSOR_HPP
+
+#include <imgclean/GSImage.hpp>
+#include <array>
+#include <cstdint>
+
+namespace imgclean::processors
+{
+//! Contrast limited adaptive histogram equalization (CLAHE). The image is split into tiles x tiles tiles,
+//! every tile gets an equalization table from its histogram with the bins clipped at clip_limit times the
+//! mean bin count, and every pixel is mapped through the tables of the four nearest tile centers with
+//! bilinear fixed-point weights. Stretches faded pages locally, the clip limit keeps noise on flat paper
+//! from being amplified.
+class ClaheProcessor
+{
+public:
+	using Histogram = std::array<uint32_t, 256>;
+	using Table     = std::array<uint8_t, 256>;
+
+	//! Default number of tiles per side
+	static constexpr int default_tiles = 8;
+	//! Default clip limit, relative to the mean bin count
+	static constexpr float default_clip_limit = 2.0f;
+	static constexpr int max_tiles            = 64;
+
+	//! Equalizes the image. Returns an empty image if tiles is outside 1 to max_tiles or clip_limit < 1.
+	//! Images smaller than the tile grid get one tile per pixel row or column.
+	static GSImage apply(const GSImage& image, int tiles = default_tiles, float clip_limit = default_clip_limit);
+
+	//! Equalization table of a histogram of num_pixels pixels. Counts above clip_limit times the mean bin
+	//! count are cut off and spread evenly over all bins before the cumulative histogram is scaled to 0-255.
+	static Table clipped_table(Histogram hist, uint32_t num_pixels, float clip_limit);
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_CLAHEPROCESSOR_HPP
@@ -0,0 +1,31 @@
+#ifndef IMG_CLEAN_PROCESSORS_DESPECKLEPROCESSOR_HPP
+#define IMG_CLEAN_PROCESSORS_DESPECKLEPROCESSOR_HPP
+
+#include <imgclean/BinaryImage.hpp>
+#include <cstdint>
+
+namespace imgclean::processors
+{
+//! Removes speckles: ink components (8-connected) with fewer pixels than a minimum area become background.
+//! Components are labeled on runs of ink pixels with a union-find. Bands of rows are labeled in parallel,
+//! then the runs on both sides of every band border are merged, so the labeling is linear in the number of
+//! runs and a clean page costs little more than one scan of its words.
+class DespeckleProcessor
+{
+public:
+	//! Default minimum area, removes isolated dots up to 2x3 pixels
+	static constexpr int default_min_area = 8;
+
+	//! Copy of the image without the components of less than min_area pixels, min_area <= 1 keeps all
+	static BinaryImage apply(const BinaryImage& image, int min_area = default_min_area);
+
+	//! Removes the components of less than min_area pixels in place
+	static void remove_speckles(BinaryImage& image, int min_area = default_min_area);
+
+private:
+	//! Rows per parallel work item of the labeling
+	static constexpr int band_rows = 128;
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_DESPECKLEPROCESSOR_HPP
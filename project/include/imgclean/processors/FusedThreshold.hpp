@@ -0,0 +1,143 @@
+#ifndef IMG_CLEAN_PROCESSORS_FUSEDTHRESHOLD_HPP
+#define IMG_CLEAN_PROCESSORS_FUSEDTHRESHOLD_HPP
+
+#include <imgclean/BinaryImage.hpp>
+#include <imgclean/PPMImage.hpp>
+#include <imgclean/processors/BoxSumEngine.hpp>
+#include <imgclean/processors/HelperProcessor.hpp>
+#include <imgclean/processors/LocalStatistics.hpp>
+#include <imgclean/processors/WindowKernel.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace imgclean::processors
+{
+//! Fused execution of rgb_to_linear_grayscale, the box statistics, a threshold rule and the bit packing.
+//! A pre-pass over the RGB image finds the maximum luma of the rescale. Row bands are then streamed through
+//! all stages per thread: every gray row is converted once into a ring of 2 * half_window + 2 rows, added to
+//! the column sums of a BoxSumEngine, thresholded and packed while it is still in cache.
+//! No full-frame gray, luma or statistics image is written, the result is bit-identical to running the
+//! conversion and the sliding-window processor one after the other.
+class FusedThreshold
+{
+public:
+	//! Binarizes with is_ink(pixel, sum, count) on the window sum, e.g. a fraction of the local mean.
+	//! window_size must be odd (see is_valid_window_size), otherwise an empty image is returned.
+	template <typename Rule>
+	static BinaryImage apply_mean(const PPMImage& image, int window_size, Rule is_ink)
+	{
+		auto pixel_is_ink = [&](uint8_t pixel, uint32_t sum, uint64_t, uint32_t count)
+		{
+			return is_ink(static_cast<float>(pixel), sum, count);
+		};
+		return run<false>(image, window_size, pixel_is_ink);
+	}
+
+	//! Binarizes with is_ink(pixel, mean, stddev) like threshold_local.
+	//! window_size must be odd (see is_valid_window_size), otherwise an empty image is returned.
+	template <typename Rule>
+	static BinaryImage apply_local(const PPMImage& image, int window_size, Rule is_ink)
+	{
+		auto pixel_is_ink = [&](uint8_t pixel, uint32_t sum, uint64_t sum_sq, uint32_t count)
+		{
+			float mean   = 0.0f;
+			float stddev = 0.0f;
+			LocalStatistics::from_sums(sum, sum_sq, count, mean, stddev);
+			return is_ink(static_cast<float>(pixel), mean, stddev);
+		};
+		return run<true>(image, window_size, pixel_is_ink);
+	}
+
+private:
+	//! Checks the input, runs the pre-pass and dispatches the half window
+	template <bool Squares, typename PixelRule>
+	static BinaryImage run(const PPMImage& image, int window_size, PixelRule is_ink)
+	{
+		if (image.empty() || !is_valid_window_size(window_size)) return BinaryImage();
+
+		BinaryImage output_image;
+		output_image.resize(image.width, image.height);
+		output_image.exif_data = image.exif_data;
+
+		const int half_window = window_size / 2;
+		const uint16_t scale  = HelperProcessor::max_luma(image);
+		auto kernel           = [&](auto half)
+		{
+			run_bands<decltype(half)::value, Squares>(image, output_image, half_window, scale, is_ink);
+		};
+		dispatch_half_window(half_window, kernel);
+
+		return output_image;
+	}
+
+	//! Band loop of BoxSumEngine::for_each_row with the gray rows produced on the fly
+	template <int Half, bool Squares, typename PixelRule>
+	static void run_bands(const PPMImage& image, BinaryImage& output_image, int half_window, uint16_t scale,
+	                      PixelRule is_ink)
+	{
+		const int width  = image.width;
+		const int height = image.height;
+		// each band pays half_window rows of warm-up, so bands are kept well above the window size
+		const int band      = std::max(128, 8 * (2 * half_window + 1));
+		const int num_bands = (height + band - 1) / band;
+		// rows y - half_window - 1 (removed) to y + half_window (added)
+		const int ring_rows = 2 * half_window + 2;
+
+#pragma omp parallel
+		{
+			BoxSumEngine engine(width, half_window, Squares);
+			std::vector<uint8_t> ring(static_cast<size_t>(ring_rows) * width);
+			std::vector<uint32_t> sums(width);
+			std::vector<uint64_t> sums_sq(Squares ? width : 0);
+			std::vector<uint32_t> counts(width);
+
+			auto ring_row = [&](int y) { return ring.data() + static_cast<size_t>(y % ring_rows) * width; };
+			//! Converts image row y into the ring
+			auto load_row = [&](int y)
+			{
+				uint8_t* row        = ring_row(y);
+				const uint16_t* rgb = image.pixels.data() + static_cast<size_t>(y) * width * 3;
+				HelperProcessor::linear_grayscale_row(rgb, width, scale, row);
+				return row;
+			};
+
+#pragma omp for schedule(static)
+			for (int b = 0; b < num_bands; ++b)
+			{
+				const int y_begin = b * band;
+				const int y_end   = std::min(height, y_begin + band);
+
+				engine.reset();
+				const int warmup_end = std::min(height, y_begin + half_window);
+				for (int y = std::max(0, y_begin - half_window); y < warmup_end; ++y)
+				{
+					engine.add_row(load_row(y));
+				}
+
+				for (int y = y_begin; y < y_end; ++y)
+				{
+					if (y + half_window < height) engine.add_row(load_row(y + half_window));
+					if (y > y_begin && y - half_window - 1 >= 0)
+					{
+						engine.remove_row(ring_row(y - half_window - 1));
+					}
+
+					uint64_t* sums_sq_ptr = Squares ? sums_sq.data() : nullptr;
+					engine.row_sums<Half>(sums.data(), sums_sq_ptr, counts.data());
+
+					const uint8_t* pixels = ring_row(y);
+					auto pixel_is_ink     = [&](int x)
+					{
+						const uint64_t sum_sq = Squares ? sums_sq[x] : 0;
+						return is_ink(pixels[x], sums[x], sum_sq, counts[x]);
+					};
+					BinaryImage::pack_row(output_image.row(y), width, pixel_is_ink);
+				}
+			}
+		}
+	}
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_FUSEDTHRESHOLD_HPP
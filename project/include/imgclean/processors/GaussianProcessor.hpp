@@ -0,0 +1,32 @@
+#ifndef IMG_CLEAN_PROCESSORS_GAUSSIANPROCESSOR_HPP
+#define IMG_CLEAN_PROCESSORS_GAUSSIANPROCESSOR_HPP
+
+#include <imgclean/GSImage.hpp>
+#include <array>
+
+namespace imgclean::processors
+{
+//! Gaussian smoothing approximated by three stacked box filters whose variances add up to sigma^2.
+//! Every box pass runs on the rolling sums of the BoxSumEngine, so the cost does not depend on sigma.
+//! Windows are clipped at the image border and the mean is taken over the pixels inside.
+class GaussianProcessor
+{
+public:
+	//! Default sigma in pixels, smooths scanner and JPEG noise without blurring body text
+	static constexpr float default_sigma = 1.0f;
+	//! Number of stacked box passes
+	static constexpr int num_boxes = 3;
+
+	//! Smooths the image, returns an empty image if sigma is not positive
+	static GSImage apply(const GSImage& image, float sigma = default_sigma);
+
+	//! Odd box widths, smallest first, whose stacked convolution has a variance close to sigma^2
+	static std::array<int, num_boxes> box_sizes(float sigma);
+
+	//! Rounded mean over the window_size x window_size window around every pixel.
+	//! window_size must be odd (see is_valid_window_size), otherwise an empty image is returned
+	static GSImage box_filter(const GSImage& image, int window_size);
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_GAUSSIANPROCESSOR_HPP
@@ -1,6 +1,7 @@
 #ifndef IMG_CLEAN_PROCESSORS_HELPERPROCESSOR_HPP
 #define IMG_CLEAN_PROCESSORS_HELPERPROCESSOR_HPP
 
+#include <imgclean/BinaryImage.hpp>
 #include <imgclean/GSImage.hpp>
 #include <imgclean/PPMImage.hpp>
 
@@ -12,38 +13,15 @@ class HelperProcessor
 {
 public:
 	//! Converts an RGB PPMImage to a normalized grayscale GSImage using linear approximation
-	static GSImage rgb_to_linear_grayscale(const PPMImage& image)
-	{
-		GSImage gray_image;
-		gray_image.width  = image.width;
-		gray_image.height = image.height;
-		gray_image.exif_data = image.exif_data; // preserve EXIF data
-		gray_image.pixels.resize(image.width * image.height);
+	//! Fixed-point kernel, vectorized with SSE4.1/AVX2 when the build targets it
+	static GSImage rgb_to_linear_grayscale(const PPMImage& image);
 
-		uint16_t max_gray = 0;
-		for (int i = 0; i < image.width * image.height; ++i)
-		{
-			const uint16_t r = image.pixels[i * 3 + 0];
-			const uint16_t g = image.pixels[i * 3 + 1];
-			const uint16_t b = image.pixels[i * 3 + 2];
-			const float gray       = 0.299f * r + 0.587f * g + 0.114f * b;
-			// +0.5f for rounding
-			const uint16_t gray_val    = static_cast<uint16_t>(gray + 0.5f);
-			gray_image.pixels[i] = gray_val;
-			if (gray_val > max_gray) max_gray = gray_val;
-		}
+	//! Largest luma of the image, the scale of rgb_to_linear_grayscale. Pre-pass of the row-wise conversion.
+	static uint16_t max_luma(const PPMImage& image);
 
-		// rescale to 0-255
-		if (max_gray == 0) max_gray = 1; // avoid division by zero
-		const float scale = 255.0f / max_gray;
-		for (int i = 0; i < image.width * image.height; ++i)
-		{
-			gray_image.pixels[i] = static_cast<uint8_t>(gray_image.pixels[i] * scale + 0.5f);
-		}
-		gray_image.maxval = 255;
-
-		return gray_image;
-	}
+	//! Row-wise rgb_to_linear_grayscale: converts n interleaved RGB pixels with the max_luma of the whole image,
+	//! the result equals the corresponding pixels of rgb_to_linear_grayscale. Lumas above max_luma become 255.
+	static void linear_grayscale_row(const uint16_t* rgb, size_t n, uint16_t max_luma, uint8_t* out);
 
 	//! Converts a grayscale GSImage to an RGB PPMImage
 	static PPMImage grayscale_to_rgb(const GSImage& gray_image)
@@ -53,9 +31,10 @@ public:
 		rgb_image.height = gray_image.height;
 		rgb_image.maxval = gray_image.maxval;
 		rgb_image.exif_data = gray_image.exif_data; // preserve EXIF data
-		rgb_image.pixels.resize(gray_image.width * gray_image.height * 3);
+		const size_t num_pixels = gray_image.pixel_count();
+		rgb_image.pixels.resize(num_pixels * 3);
 
-		for (int i = 0; i < gray_image.width * gray_image.height; ++i)
+		for (size_t i = 0; i < num_pixels; ++i)
 		{
 			const uint16_t gray               = gray_image.pixels[i];
 			rgb_image.pixels[i * 3 + 0] = gray;
@@ -65,6 +44,12 @@ public:
 
 		return rgb_image;
 	}
+
+	//! Expands a BinaryImage to a GSImage, ink becomes 0 and background 255
+	static GSImage binary_to_grayscale(const BinaryImage& binary_image);
+
+	//! Packs a GSImage into a BinaryImage, pixels below the threshold become ink
+	static BinaryImage grayscale_to_binary(const GSImage& gray_image, uint8_t threshold = 128);
 };
 } // namespace processors
 } // namespace imgclean
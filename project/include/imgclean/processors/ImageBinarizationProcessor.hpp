@@ -1,21 +1,37 @@
 #ifndef IMG_CLEAN_PROCESSORS_IMAGEBINARIZATION_HPP
 #define IMG_CLEAN_PROCESSORS_IMAGEBINARIZATION_HPP
 
+#include <imgclean/BinaryImage.hpp>
 #include <imgclean/GSImage.hpp>
+#include <imgclean/processors/BoxSumEngine.hpp>
 
 namespace imgclean::processors
 {
 class ImageBinarizationProcessor
 {
 public:
+	//! Default window size for the local statistics
+	static constexpr int default_window_size = 15;
+
 	//! Preprocesses the PPM Image with a binarization & local thresholding method
-	static GSImage apply(const GSImage& image);
+	//! The engine selects how the window sums are computed, both give identical results
+	//! window_size must be odd (see is_valid_window_size), otherwise an empty image is returned
+	//! Runs apply_binary and expands the bits to 0/255 bytes, the extra pass is small next to the statistics
+	static GSImage apply(const GSImage& image, WindowEngine engine = WindowEngine::INTEGRAL_IMAGE,
+	                     int window_size = default_window_size);
+
+	//! Same as apply, but writes the result bit-packed, pixels below the threshold become ink.
+	//! The threshold is normalized by the stddev extrema of the whole page. SLIDING_WINDOW reads the rolling sums
+	//! twice, once for the extrema and once for the thresholds, and keeps no full-frame statistics.
+	//! INTEGRAL_IMAGE looks every window up once and stores its mean and stddev.
+	static BinaryImage apply_binary(const GSImage& image, WindowEngine engine = WindowEngine::INTEGRAL_IMAGE,
+	                                int window_size = default_window_size);
 
-private:
-	//! Threshold factor
-	static constexpr int window_size = 15;
-	//! Half of the window size
-	static constexpr int half_window = window_size / 2;
+	//! Fast approximation of apply_binary: the statistics are evaluated on every grid_factor-th row and column
+	//! only and the threshold is bilinearly interpolated in between, see ThresholdSurface.
+	//! grid_factor = 1 runs apply_binary. Returns an empty image for an invalid window or factor.
+	static BinaryImage apply_approximate(const GSImage& image, WindowEngine engine, int window_size,
+	                                     int grid_factor);
 };
 } // namespace imgclean::processors
 
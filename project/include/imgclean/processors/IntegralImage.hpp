@@ -0,0 +1,248 @@
+#ifndef IMG_CLEAN_PROCESSORS_INTEGRALIMAGE_HPP
+#define IMG_CLEAN_PROCESSORS_INTEGRALIMAGE_HPP
+
+#include <imgclean/GSImage.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace imgclean::processors
+{
+//! Number of columns one thread accumulates at a time in the vertical pass
+inline constexpr size_t integral_column_block = 256;
+//! Number of rows of one band of the vertical pass of an untiled table, tiled tables use their tile rows
+inline constexpr size_t integral_row_block = 256;
+
+//! Builds the padded integral image of f(pixel) into dst, size = (width + 1) * (height + 1).
+//! Two-phase prefix sum: independent row scans, then column scans over blocks of rows and columns,
+//! so both phases run in parallel and touch memory in row-major order.
+//! If tile is non-zero, the sums restart every tile rows/columns, i.e. each entry (x, y) only holds
+//! the sum over [x0, x) x [y0, y) where (x0, y0) is the origin of its tile.
+template <typename T, typename Transform>
+void build_integral_image(const GSImage& image, T* dst, Transform f, size_t tile = 0)
+{
+	const size_t width  = static_cast<size_t>(image.width);
+	const size_t height = static_cast<size_t>(image.height);
+	const size_t stride = width + 1;
+
+	//! True if row/column i of the padded table is the origin of a tile and therefore zero
+	auto is_origin = [tile](size_t i) { return i == 0 || (tile != 0 && i % tile == 0); };
+
+	// zero padding row on top
+	std::fill(dst, dst + stride, T(0));
+
+	// phase 1: horizontal prefix sums, one row per iteration
+#pragma omp parallel for schedule(static)
+	for (size_t y = 0; y < height; ++y)
+	{
+		const uint8_t* row = image.pixels.data() + y * width;
+		T* out             = dst + (y + 1) * stride;
+		if (is_origin(y + 1))
+		{
+			std::fill(out, out + stride, T(0));
+			continue;
+		}
+
+		const size_t run = tile != 0 ? tile : stride;
+		for (size_t x0 = 0; x0 < stride; x0 += run)
+		{
+			const size_t x_end = std::min(stride, x0 + run);
+			T acc              = 0;
+			out[x0]            = 0;
+			for (size_t x = x0 + 1; x < x_end; ++x)
+			{
+				acc += f(row[x - 1]);
+				out[x] = acc;
+			}
+		}
+	}
+
+	// phase 2: vertical prefix sums over blocks of band_rows x integral_column_block, so the number of tasks grows
+	// with the image area and not only with its width. Each block is prefixed on its own, then every band adds the
+	// last row of the band above. The bands of a tiled table start at tile origins and need no carry.
+	const size_t band_rows  = tile != 0 ? tile : integral_row_block;
+	const size_t num_bands  = height / band_rows + 1;
+	const size_t num_blocks = (width + integral_column_block - 1) / integral_column_block;
+	auto band_begin         = [&](size_t band) { return band * band_rows; };
+	auto band_end           = [&](size_t band) { return std::min(height + 1, (band + 1) * band_rows); };
+	auto block_begin        = [&](size_t block) { return 1 + block * integral_column_block; };
+	auto block_end          = [&](size_t block) { return std::min(stride, 1 + (block + 1) * integral_column_block); };
+
+	//! row[x] += add[x] over the columns of a block
+	auto add_row = [&](T* row, const T* add, size_t block)
+	{
+		const size_t x_end = block_end(block);
+#pragma omp simd
+		for (size_t x = block_begin(block); x < x_end; ++x)
+		{
+			row[x] += add[x];
+		}
+	};
+
+#pragma omp parallel for collapse(2) schedule(static)
+	for (size_t band = 0; band < num_bands; ++band)
+	{
+		for (size_t block = 0; block < num_blocks; ++block)
+		{
+			for (size_t y = band_begin(band) + 1; y < band_end(band); ++y)
+			{
+				if (is_origin(y) || is_origin(y - 1)) continue;
+				add_row(dst + y * stride, dst + (y - 1) * stride, block);
+			}
+		}
+	}
+	if (tile != 0 || num_bands < 2) return;
+
+	// carry: the last rows of the bands are completed top to bottom, then every other row adds the completed
+	// last row of the band above
+#pragma omp parallel for schedule(static)
+	for (size_t block = 0; block < num_blocks; ++block)
+	{
+		for (size_t band = 1; band < num_bands; ++band)
+		{
+			add_row(dst + (band_end(band) - 1) * stride, dst + (band_begin(band) - 1) * stride, block);
+		}
+	}
+#pragma omp parallel for collapse(2) schedule(static)
+	for (size_t band = 1; band < num_bands; ++band)
+	{
+		for (size_t block = 0; block < num_blocks; ++block)
+		{
+			const T* carry = dst + (band_begin(band) - 1) * stride;
+			for (size_t y = band_begin(band); y + 1 < band_end(band); ++y)
+			{
+				add_row(dst + y * stride, carry, block);
+			}
+		}
+	}
+}
+
+//! Integral image that stays exact for arbitrarily large images without 64 bits per pixel.
+//! The padded table is split into tile_size x tile_size tiles. Each entry stores in 32 bits the sum
+//! relative to the origin (x0, y0) of its tile, the absolute value is restored from 64-bit sums along
+//! the tile borders: I(x, y) = I(x0, y) + I(x, y0) - I(x0, y0) + R(x, y)
+class TiledIntegralImage
+{
+public:
+	//! Tile edge length, (tile_size - 1)^2 * 255^2 still fits in 32 bits, so squares can be stored too
+	static constexpr size_t tile_size = 256;
+
+	//! Builds the tiled integral image of f(pixel), f must not exceed 255 * 255
+	template <typename Transform>
+	static TiledIntegralImage build(const GSImage& image, Transform f)
+	{
+		TiledIntegralImage table;
+		if (image.empty()) return table;
+
+		const size_t width  = static_cast<size_t>(image.width);
+		const size_t height = static_cast<size_t>(image.height);
+		const size_t stride = width + 1;
+		table.width         = width;
+		table.height        = height;
+		table.tiles_x       = width / tile_size + 1;
+		table.tiles_y       = height / tile_size + 1;
+
+		// tile-relative sums
+		table.relative.resize(stride * (height + 1));
+		auto relative_f = [&](uint8_t v) { return static_cast<uint32_t>(f(v)); };
+		build_integral_image(image, table.relative.data(), relative_f, tile_size);
+
+		// I(x0, y) for every vertical tile border x0: prefix over the rows of the row sums left of x0
+		table.column_lines.assign((height + 1) * table.tiles_x, 0);
+#pragma omp parallel for schedule(static)
+		for (size_t y = 0; y < height; ++y)
+		{
+			const uint8_t* row = image.pixels.data() + y * width;
+			uint64_t* out      = table.column_lines.data() + (y + 1) * table.tiles_x;
+			uint64_t acc       = 0;
+			for (size_t tx = 0; tx < table.tiles_x; ++tx)
+			{
+				out[tx]            = acc;
+				const size_t x_end = std::min(width, (tx + 1) * tile_size);
+				for (size_t x = tx * tile_size; x < x_end; ++x)
+				{
+					acc += f(row[x]);
+				}
+			}
+		}
+		for (size_t y = 1; y <= height; ++y)
+		{
+			uint64_t* out        = table.column_lines.data() + y * table.tiles_x;
+			const uint64_t* prev = table.column_lines.data() + (y - 1) * table.tiles_x;
+			for (size_t tx = 0; tx < table.tiles_x; ++tx)
+			{
+				out[tx] += prev[tx];
+			}
+		}
+
+		// I(x, y0) for every horizontal tile border y0: column sums of each band of rows,
+		// accumulated over the bands and then prefixed along the row
+		table.row_lines.assign(table.tiles_y * stride, 0);
+#pragma omp parallel for schedule(static)
+		for (size_t ty = 1; ty < table.tiles_y; ++ty)
+		{
+			uint64_t* out = table.row_lines.data() + ty * stride;
+			for (size_t y = (ty - 1) * tile_size; y < ty * tile_size; ++y)
+			{
+				const uint8_t* row = image.pixels.data() + y * width;
+				for (size_t x = 0; x < width; ++x)
+				{
+					out[x + 1] += f(row[x]);
+				}
+			}
+		}
+		for (size_t ty = 1; ty < table.tiles_y; ++ty)
+		{
+			uint64_t* out        = table.row_lines.data() + ty * stride;
+			const uint64_t* prev = table.row_lines.data() + (ty - 1) * stride;
+			// prev is already prefixed along x, so out becomes the prefix of the band plus the one above
+			uint64_t acc = 0;
+			for (size_t x = 1; x < stride; ++x)
+			{
+				acc += out[x];
+				out[x] = acc + prev[x];
+			}
+		}
+
+		return table;
+	}
+
+	//! Absolute integral I(x, y) = sum over [0, x) x [0, y), x <= width, y <= height
+	uint64_t at(size_t x, size_t y) const
+	{
+		const size_t stride = width + 1;
+		const size_t tx     = x / tile_size;
+		const size_t ty     = y / tile_size;
+		const uint64_t* row = row_lines.data() + ty * stride;
+		return column_lines[y * tiles_x + tx] + row[x] - row[tx * tile_size] + relative[y * stride + x];
+	}
+
+	//! Sum over the window spanning [x1, x2] x [y1, y2] (inclusive)
+	uint64_t box_sum(int x1, int y1, int x2, int y2) const
+	{
+		const size_t left   = static_cast<size_t>(x1);
+		const size_t right  = static_cast<size_t>(x2) + 1;
+		const size_t top    = static_cast<size_t>(y1);
+		const size_t bottom = static_cast<size_t>(y2) + 1;
+		return at(right, bottom) - at(left, bottom) - at(right, top) + at(left, top);
+	}
+
+	//! Sum over the whole image
+	uint64_t total() const { return at(width, height); }
+
+private:
+	size_t width   = 0;
+	size_t height  = 0;
+	size_t tiles_x = 0;
+	size_t tiles_y = 0;
+	//! Sums relative to the tile origin, size = (width + 1) * (height + 1)
+	std::vector<uint32_t> relative;
+	//! I(tx * tile_size, y), size = (height + 1) * tiles_x
+	std::vector<uint64_t> column_lines;
+	//! I(x, ty * tile_size), size = tiles_y * (width + 1)
+	std::vector<uint64_t> row_lines;
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_INTEGRALIMAGE_HPP
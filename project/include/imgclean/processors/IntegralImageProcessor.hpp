@@ -1,7 +1,11 @@
 #ifndef IMG_CLEAN_PROCESSORS_INTEGRALIMAGEPROCESSOR_HPP
 #define IMG_CLEAN_PROCESSORS_INTEGRALIMAGEPROCESSOR_HPP
 
+#include <imgclean/BinaryImage.hpp>
 #include <imgclean/GSImage.hpp>
+#include <imgclean/PPMImage.hpp>
+#include <imgclean/processors/BoxSumEngine.hpp>
+#include <imgclean/processors/ThresholdStream.hpp>
 
 namespace imgclean
 {
@@ -10,15 +14,34 @@ namespace processors
 class IntegralImageProcessor
 {
 public:
-	static GSImage apply(const GSImage& image);
+	//! Default window size for local mean calculation
+	static constexpr int default_window_size = 15;
+	//! Default threshold factor
+	static constexpr float default_t = 0.85f;
 
-private:
-	//! Window size for local mean calculation
-	static constexpr int window_size = 15;
-	//! Half of the window size
-	static constexpr int half_window = window_size / 2;
-	//! Threshold factor
-	static constexpr float t = 0.85f;
+	//! Binarizes the image against a fraction t of the mean over a window_size x window_size window
+	//! The engine selects how the window sums are computed, both give identical results
+	//! window_size must be odd (see is_valid_window_size), otherwise an empty image is returned
+	//! Runs apply_binary and expands the bits to 0/255 bytes, an extra pass over the page,
+	//! so stages that only need the ink should call apply_binary
+	static GSImage apply(const GSImage& image, WindowEngine engine = WindowEngine::INTEGRAL_IMAGE,
+	                     int window_size = default_window_size, float t = default_t);
+
+	//! Same as apply, but writes the result bit-packed, pixels below the threshold become ink
+	static BinaryImage apply_binary(const GSImage& image, WindowEngine engine = WindowEngine::INTEGRAL_IMAGE,
+	                                int window_size = default_window_size, float t = default_t);
+
+	//! Fast approximation of apply_binary: the local mean is evaluated on every grid_factor-th row and column
+	//! only and the threshold is bilinearly interpolated in between, see ThresholdSurface.
+	//! grid_factor = 1 runs apply_binary. Returns an empty image for an invalid window or factor.
+	static BinaryImage apply_approximate(const GSImage& image, WindowEngine engine, int window_size, float t,
+	                                     int grid_factor);
+
+	//! Fused rgb_to_linear_grayscale and apply_binary in one pass over row strips, see FusedThreshold
+	static BinaryImage apply_rgb(const PPMImage& image, int window_size = default_window_size, float t = default_t);
+
+	//! apply_binary for rows of the given width that are pushed one at a time, see ThresholdStream
+	static ThresholdStream stream(int width, int window_size = default_window_size, float t = default_t);
 };
 } // namespace processors
 } // namespace imgclean
@@ -0,0 +1,54 @@
+#ifndef IMG_CLEAN_PROCESSORS_LOCALSTATISTICS_HPP
+#define IMG_CLEAN_PROCESSORS_LOCALSTATISTICS_HPP
+
+#include <imgclean/GSImage.hpp>
+#include <imgclean/processors/IntegralImage.hpp>
+#include <cmath>
+#include <cstdint>
+
+namespace imgclean::processors
+{
+//! Integral images of the pixel values and of their squares.
+//! Mean and standard deviation of any rectangular window can be read in O(1).
+struct LocalStatistics
+{
+	//! Integral image of the pixel values
+	TiledIntegralImage sum;
+	//! Integral image of the squared pixel values
+	TiledIntegralImage sum_sq;
+
+	//! Builds both integral images of a gray scale image
+	static LocalStatistics compute(const GSImage& image);
+
+	//! Variance Var(X) = E[X^2] - E[X]^2 from the sum, the sum of squares and the number of pixels of a window.
+	//! Rounding can make it slightly negative in flat regions, see stddev_of.
+	static double variance(uint64_t s, uint64_t sq, uint32_t count)
+	{
+		const double n = static_cast<double>(count);
+		const double m = static_cast<double>(s) / n;
+		return static_cast<double>(sq) / n - m * m;
+	}
+
+	//! Standard deviation of a variance, clamped at 0. It never decreases with the variance, so the extrema
+	//! of the variance over a region give the extrema of the stddev.
+	static float stddev_of(double var) { return var > 0.0 ? static_cast<float>(std::sqrt(var)) : 0.0f; }
+
+	//! Mean and standard deviation from the sum, the sum of squares and the number of pixels of a window
+	static void from_sums(uint64_t s, uint64_t sq, uint32_t count, float& mean, float& stddev)
+	{
+		mean   = static_cast<float>(static_cast<double>(s) / static_cast<double>(count));
+		stddev = stddev_of(variance(s, sq, count));
+	}
+
+	//! Mean and standard deviation of the window spanning [x1, x2] x [y1, y2] (inclusive)
+	void window(int x1, int y1, int x2, int y2, float& mean, float& stddev) const
+	{
+		const uint64_t s  = sum.box_sum(x1, y1, x2, y2);
+		const uint64_t sq = sum_sq.box_sum(x1, y1, x2, y2);
+
+		from_sums(s, sq, static_cast<uint32_t>((x2 - x1 + 1) * (y2 - y1 + 1)), mean, stddev);
+	}
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_LOCALSTATISTICS_HPP
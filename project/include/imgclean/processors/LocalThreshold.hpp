@@ -0,0 +1,188 @@
+#ifndef IMG_CLEAN_PROCESSORS_LOCALTHRESHOLD_HPP
+#define IMG_CLEAN_PROCESSORS_LOCALTHRESHOLD_HPP
+
+#include <imgclean/BinaryImage.hpp>
+#include <imgclean/GSImage.hpp>
+#include <imgclean/processors/BoxSumEngine.hpp>
+#include <imgclean/processors/LocalStatistics.hpp>
+#include <imgclean/processors/ThresholdStream.hpp>
+#include <imgclean/processors/WindowKernel.hpp>
+#include <algorithm>
+#include <cstdint>
+
+namespace imgclean::processors
+{
+//! Window statistics of one image row, read from the rolling sums of the BoxSumEngine
+struct SlidingWindowRow
+{
+	const uint32_t* sums;
+	const uint64_t* sums_sq;
+	const uint32_t* counts;
+
+	//! Mean and stddev of the window centered on column x
+	void stats(int x, float& mean, float& stddev) const
+	{
+		LocalStatistics::from_sums(sums[x], sums_sq[x], counts[x], mean, stddev);
+	}
+
+	//! Variance of the window centered on column x, see LocalStatistics::variance
+	double variance(int x) const { return LocalStatistics::variance(sums[x], sums_sq[x], counts[x]); }
+};
+
+//! Window statistics of one image row, read from the integral images
+template <int Half>
+struct IntegralWindowRow
+{
+	const LocalStatistics& local;
+	int y1;
+	int y2;
+	int half_window;
+	int width;
+
+	//! Mean and stddev of the window centered on column x
+	void stats(int x, float& mean, float& stddev) const
+	{
+		const int half = Half > 0 ? Half : half_window;
+		const int x1   = std::max(0, x - half);
+		const int x2   = std::min(width - 1, x + half);
+		local.window(x1, y1, x2, y2, mean, stddev);
+	}
+};
+
+//! Shared O(1)-per-pixel mean/stddev engine of the local thresholding processors.
+//! for_each_row(fn) calls fn(y, row) once per image row, row.stats(x, mean, stddev) then yields the statistics
+//! of the window_size x window_size window around (x, y). The integral images are built once in the constructor,
+//! so several passes over the statistics only pay for the lookups.
+class LocalStatisticsEngine
+{
+public:
+	//! window_size must be odd, see is_valid_window_size
+	LocalStatisticsEngine(const GSImage& image, WindowEngine engine, int window_size)
+		: image(image)
+		, engine(engine)
+		, half_window(window_size / 2)
+	{
+		if (engine == WindowEngine::INTEGRAL_IMAGE) local = LocalStatistics::compute(image);
+	}
+
+	const GSImage& source() const { return image; }
+
+	//! Visits the rows in parallel, fn may only write to data of row y
+	template <typename RowFn>
+	void for_each_row(RowFn fn) const
+	{
+		if (engine == WindowEngine::SLIDING_WINDOW)
+		{
+			for_each_sliding_row(fn);
+			return;
+		}
+		for_each_integral_row(fn);
+	}
+
+	//! for_each_row of WindowEngine::SLIDING_WINDOW only, fn is not instantiated for the integral images
+	template <typename RowFn>
+	void for_each_sliding_row(RowFn fn) const
+	{
+		if (image.empty()) return;
+
+		auto kernel = [&](auto half)
+		{
+			auto row_fn = [&](int y, const uint32_t* sums, const uint64_t* sq, const uint32_t* n)
+			{
+				fn(y, SlidingWindowRow{sums, sq, n});
+			};
+			BoxSumEngine::for_each_row<decltype(half)::value>(image, half_window, true, row_fn);
+		};
+		dispatch_half_window(half_window, kernel);
+	}
+
+	//! for_each_row of WindowEngine::INTEGRAL_IMAGE only, the engine must have been created with it
+	template <typename RowFn>
+	void for_each_integral_row(RowFn fn) const
+	{
+		if (image.empty()) return;
+
+		const int width  = image.width;
+		const int height = image.height;
+		auto kernel      = [&](auto half)
+		{
+			constexpr int Half = decltype(half)::value;
+			const int h        = Half > 0 ? Half : half_window;
+#pragma omp parallel for schedule(static)
+			for (int y = 0; y < height; ++y)
+			{
+				const int y1 = std::max(0, y - h);
+				const int y2 = std::min(height - 1, y + h);
+				fn(y, IntegralWindowRow<Half>{local, y1, y2, half_window, width});
+			}
+		};
+		dispatch_half_window(half_window, kernel);
+	}
+
+private:
+	const GSImage& image;
+	WindowEngine engine;
+	int half_window;
+	//! Integral images, only built for WindowEngine::INTEGRAL_IMAGE
+	LocalStatistics local;
+};
+
+//! Binarizes the image with a rule on the local statistics, is_ink(pixel, mean, stddev) decides per pixel
+template <typename Rule>
+BinaryImage threshold_local(const LocalStatisticsEngine& windows, Rule is_ink)
+{
+	const GSImage& image = windows.source();
+	const int width      = image.width;
+
+	BinaryImage output_image;
+	output_image.resize(width, image.height);
+	output_image.exif_data = image.exif_data;
+
+	auto threshold_row = [&](int y, const auto& row)
+	{
+		const uint8_t* pixels = image.pixels.data() + static_cast<size_t>(y) * width;
+		auto pixel_is_ink     = [&](int x)
+		{
+			float mean   = 0.0f;
+			float stddev = 0.0f;
+			row.stats(x, mean, stddev);
+			return is_ink(static_cast<float>(pixels[x]), mean, stddev);
+		};
+		BinaryImage::pack_row(output_image.row(y), width, pixel_is_ink);
+	};
+	windows.for_each_row(threshold_row);
+
+	return output_image;
+}
+
+//! Single-pass variant, returns an empty image if the image is empty or window_size is invalid
+template <typename Rule>
+BinaryImage threshold_local(const GSImage& image, WindowEngine engine, int window_size, Rule is_ink)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return BinaryImage();
+	return threshold_local(LocalStatisticsEngine(image, engine, window_size), is_ink);
+}
+
+//! Push-based threshold_local for rows of the given width, see ThresholdStream.
+//! Returns an empty stream if width is not positive or window_size is invalid.
+template <typename Rule>
+ThresholdStream stream_local(int width, int window_size, Rule is_ink)
+{
+	auto threshold_row = [width, is_ink](const uint8_t* pixels, const uint32_t* sums, const uint64_t* sums_sq,
+	                                     const uint32_t* counts, uint64_t* out)
+	{
+		const SlidingWindowRow row{sums, sums_sq, counts};
+		auto pixel_is_ink = [&](int x)
+		{
+			float mean   = 0.0f;
+			float stddev = 0.0f;
+			row.stats(x, mean, stddev);
+			return is_ink(static_cast<float>(pixels[x]), mean, stddev);
+		};
+		BinaryImage::pack_row(out, width, pixel_is_ink);
+	};
+	return ThresholdStream(width, window_size, true, threshold_row);
+}
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_LOCALTHRESHOLD_HPP
@@ -0,0 +1,32 @@
+#ifndef IMG_CLEAN_PROCESSORS_MEDIANPROCESSOR_HPP
+#define IMG_CLEAN_PROCESSORS_MEDIANPROCESSOR_HPP
+
+#include <imgclean/GSImage.hpp>
+#include <cstdint>
+
+namespace imgclean::processors
+{
+//! Median filter over a square window in constant time per pixel (Perreault and Hebert): every column keeps
+//! a histogram of its window_size pixels, sliding down costs one add and one remove per column, and the
+//! window histogram slides right by adding one column histogram and subtracting another. Histograms are
+//! split into 16 coarse and 16 x 16 fine bins, a fine segment is only brought up to date when the median
+//! falls into it. Image borders are replicated. Columns are processed in parallel strips.
+class MedianProcessor
+{
+public:
+	//! Default window, removes single-pixel noise
+	static constexpr int default_window_size = 3;
+	//! Largest window, the window histogram counts up to window_size^2 pixels in 16 bits
+	static constexpr int max_window_size = 255;
+
+	//! Median of the window_size x window_size window around every pixel.
+	//! Returns an empty image if window_size is even or outside 1 to max_window_size.
+	static GSImage apply(const GSImage& image, int window_size = default_window_size);
+
+private:
+	//! Output columns per parallel work item, the strip reads window_size - 1 more columns
+	static constexpr int strip_columns = 256;
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_MEDIANPROCESSOR_HPP
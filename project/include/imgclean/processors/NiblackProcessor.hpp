@@ -0,0 +1,38 @@
+#ifndef IMG_CLEAN_PROCESSORS_NIBLACKPROCESSOR_HPP
+#define IMG_CLEAN_PROCESSORS_NIBLACKPROCESSOR_HPP
+
+#include <imgclean/BinaryImage.hpp>
+#include <imgclean/GSImage.hpp>
+#include <imgclean/PPMImage.hpp>
+#include <imgclean/processors/BoxSumEngine.hpp>
+#include <imgclean/processors/ThresholdStream.hpp>
+
+namespace imgclean::processors
+{
+//! Niblack thresholding: T = m + k * s with the local mean m and stddev s
+class NiblackProcessor
+{
+public:
+	//! Default window size for the local statistics
+	static constexpr int default_window_size = 15;
+	//! Default weight of the local stddev, negative so that the threshold stays below the mean
+	static constexpr float default_k = -0.2f;
+
+	//! Binarizes the image, pixels below T become black
+	//! window_size must be odd (see is_valid_window_size), otherwise an empty image is returned
+	static GSImage apply(const GSImage& image, WindowEngine engine = WindowEngine::INTEGRAL_IMAGE,
+	                     int window_size = default_window_size, float k = default_k);
+
+	//! Same as apply, but writes the result bit-packed, pixels below T become ink
+	static BinaryImage apply_binary(const GSImage& image, WindowEngine engine = WindowEngine::INTEGRAL_IMAGE,
+	                                int window_size = default_window_size, float k = default_k);
+
+	//! Fused rgb_to_linear_grayscale and apply_binary in one pass over row strips, see FusedThreshold
+	static BinaryImage apply_rgb(const PPMImage& image, int window_size = default_window_size, float k = default_k);
+
+	//! apply_binary for rows of the given width that are pushed one at a time, see ThresholdStream
+	static ThresholdStream stream(int width, int window_size = default_window_size, float k = default_k);
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_NIBLACKPROCESSOR_HPP
@@ -0,0 +1,37 @@
+#ifndef IMG_CLEAN_PROCESSORS_OTSUPROCESSOR_HPP
+#define IMG_CLEAN_PROCESSORS_OTSUPROCESSOR_HPP
+
+#include <imgclean/BinaryImage.hpp>
+#include <imgclean/GSImage.hpp>
+#include <array>
+#include <cstdint>
+
+namespace imgclean::processors
+{
+//! Global Otsu thresholding: one threshold for the whole image that maximizes the between-class variance
+//! of the gray value histogram. Far cheaper than the windowed methods, suited to evenly lit scans.
+class OtsuProcessor
+{
+public:
+	using Histogram = std::array<uint64_t, 256>;
+
+	//! Binarizes the image, pixels below the Otsu threshold become black
+	static GSImage apply(const GSImage& image);
+
+	//! Same as apply, but writes the result bit-packed, pixels below the Otsu threshold become ink
+	static BinaryImage apply_binary(const GSImage& image);
+
+	//! 256-bin histogram of the gray values
+	static Histogram histogram(const GSImage& image);
+
+	//! Otsu threshold T of a histogram, pixels with a value < T form the dark class.
+	//! Returns 0 (no dark class) if the histogram holds less than two distinct values.
+	static int threshold(const Histogram& hist);
+
+private:
+	//! Pixels per parallel work item, counted in 32 bits before being merged into the 64-bit histogram
+	static constexpr size_t chunk_pixels = size_t(1) << 20;
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_OTSUPROCESSOR_HPP
@@ -0,0 +1,68 @@
+#ifndef IMG_CLEAN_PROCESSORS_THRESHOLDSTREAM_HPP
+#define IMG_CLEAN_PROCESSORS_THRESHOLDSTREAM_HPP
+
+#include <imgclean/processors/BoxSumEngine.hpp>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace imgclean::processors
+{
+//! Push-based sliding-window thresholding for rows that arrive one after another, e.g. from a scanner.
+//! Every gray row is copied into a ring of 2 * half_window + 2 rows and added to the column sums of a
+//! BoxSumEngine. Row y is thresholded as soon as row y + half_window arrived, so the output lags the input by
+//! half_window rows, finish() emits the last rows of the page. The result is bit-identical to apply_binary of
+//! the processor on the whole page.
+class ThresholdStream
+{
+public:
+	//! Thresholds one row: rule(pixels, sums, sums_sq, counts, out) packs the row into out.
+	//! sums_sq is nullptr if the stream keeps no sums of squares.
+	using RowRule = std::function<void(const uint8_t* pixels, const uint32_t* sums, const uint64_t* sums_sq,
+	                                   const uint32_t* counts, uint64_t* out)>;
+	//! Receives row y, bit-packed like a row of a BinaryImage
+	using RowSink = std::function<void(int y, const uint64_t* row)>;
+
+	//! An empty stream, see empty()
+	ThresholdStream() = default;
+
+	//! window_size must be odd (see is_valid_window_size) and width positive, otherwise the stream is empty
+	ThresholdStream(int width, int window_size, bool squares, RowRule rule);
+
+	//! True if the stream was not set up, pushing rows has no effect then
+	bool empty() const { return rule == nullptr; }
+
+	int width() const { return row_width; }
+
+	//! Rows between a pushed row and the row emitted with it
+	int latency() const { return half_window; }
+
+	//! Adds the next row of width gray pixels, emits the row half_window rows above it if there is one
+	void push_row(const uint8_t* row, const RowSink& sink);
+
+	//! Emits the rows still waiting for the rows below them, the next pushed row starts a new page at y = 0
+	void finish(const RowSink& sink);
+
+private:
+	uint8_t* ring_row(int y) { return ring.data() + static_cast<size_t>(y % ring_rows) * row_width; }
+
+	//! Removes the row that left the window of row y, thresholds row y and hands it to the sink
+	void emit(int y, const RowSink& sink);
+
+	int row_width   = 0;
+	int half_window = 0;
+	int ring_rows   = 0;
+	//! Rows pushed since the start of the page
+	int rows_in = 0;
+	BoxSumEngine engine{0, 0, false};
+	RowRule rule;
+	//! Rows y - half_window - 1 (still to be removed) to y + half_window (just added)
+	std::vector<uint8_t> ring;
+	std::vector<uint32_t> sums;
+	std::vector<uint64_t> sums_sq;
+	std::vector<uint32_t> counts;
+	std::vector<uint64_t> packed;
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_THRESHOLDSTREAM_HPP
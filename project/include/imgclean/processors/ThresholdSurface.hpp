@@ -0,0 +1,86 @@
+#ifndef IMG_CLEAN_PROCESSORS_THRESHOLDSURFACE_HPP
+#define IMG_CLEAN_PROCESSORS_THRESHOLDSURFACE_HPP
+
+#include <imgclean/BinaryImage.hpp>
+#include <imgclean/GSImage.hpp>
+#include <imgclean/processors/BoxSumEngine.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace imgclean::processors
+{
+//! Thresholds sampled on a coarse grid and bilinearly interpolated at full resolution.
+//! Local thresholds vary slowly across a page, so the window statistics only need to be evaluated at every
+//! factor-th row and column (plus the last ones). The samples are exact, only the interpolation between them
+//! approximates the full-resolution threshold. factor = 1 samples every pixel.
+class ThresholdSurface
+{
+public:
+	//! Largest supported grid factor
+	static constexpr int max_factor = 16;
+
+	static bool is_valid_factor(int factor) { return factor >= 1 && factor <= max_factor; }
+
+	//! Empty surface for an image of width x height, factor must be valid
+	ThresholdSurface(int width, int height, int factor);
+
+	int columns() const { return grid_columns; }
+	int rows() const { return grid_rows; }
+	int factor() const { return grid_factor; }
+
+	//! Pixel column of grid column i
+	int x(int i) const { return std::min(i * grid_factor, width - 1); }
+	//! Pixel row of grid row j
+	int y(int j) const { return std::min(j * grid_factor, height - 1); }
+
+	float& at(int i, int j) { return values[static_cast<size_t>(j) * grid_columns + i]; }
+	float at(int i, int j) const { return values[static_cast<size_t>(j) * grid_columns + i]; }
+
+	//! Calls fn(i, j, sum, sum_sq, count) with the window sums of every grid point, grid rows in parallel.
+	//! sum_sq is 0 if squares is false. Half is passed on to BoxSumEngine::row_sums.
+	template <int Half = 0, typename SampleFn>
+	void for_each_sample(const GSImage& image, int half_window, bool squares, SampleFn fn) const
+	{
+		auto sample_row = [&](int row, const uint32_t* sums, const uint64_t* sums_sq, const uint32_t* counts)
+		{
+			// sampled rows are the multiples of the factor and the last row
+			const int j = row % grid_factor == 0 ? row / grid_factor : grid_rows - 1;
+			for (int i = 0; i < grid_columns; ++i)
+			{
+				const int col = x(i);
+				fn(i, j, sums[col], squares ? sums_sq[col] : 0, counts[col]);
+			}
+		};
+		BoxSumEngine::for_each_row<Half>(image, half_window, squares, sample_row, grid_factor);
+	}
+
+	//! Calls fn(i, j, x, y) for every grid point, grid rows in parallel
+	template <typename PointFn>
+	void for_each_point(PointFn fn) const
+	{
+#pragma omp parallel for schedule(static)
+		for (int j = 0; j < grid_rows; ++j)
+		{
+			for (int i = 0; i < grid_columns; ++i)
+			{
+				fn(i, j, x(i), y(j));
+			}
+		}
+	}
+
+	//! Pixels below the interpolated threshold become ink
+	BinaryImage binarize(const GSImage& image) const;
+
+private:
+	int width        = 0;
+	int height       = 0;
+	int grid_factor  = 1;
+	int grid_columns = 0;
+	int grid_rows    = 0;
+	//! Threshold of every grid point, row-major
+	std::vector<float> values;
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_THRESHOLDSURFACE_HPP
@@ -0,0 +1,33 @@
+#ifndef IMG_CLEAN_PROCESSORS_WINDOWKERNEL_HPP
+#define IMG_CLEAN_PROCESSORS_WINDOWKERNEL_HPP
+
+#include <type_traits>
+
+namespace imgclean::processors
+{
+//! Largest supported window, (4095^2) * 255 still fits the 32-bit window sums
+inline constexpr int max_window_size = 4095;
+
+//! Window sizes must be odd so that the window is centered on its pixel
+inline bool is_valid_window_size(int window_size)
+{
+	return window_size >= 1 && window_size <= max_window_size && window_size % 2 == 1;
+}
+
+//! Calls fn(std::integral_constant<int, H>{}) with H = half_window for the common windows 15, 31 and 63,
+//! so that kernels templated on H get their window math constant-folded.
+//! Every other size is dispatched with H = 0, kernels then fall back to the runtime half_window.
+template <typename Fn>
+decltype(auto) dispatch_half_window(int half_window, Fn&& fn)
+{
+	switch (half_window)
+	{
+	case 7: return fn(std::integral_constant<int, 7>{});
+	case 15: return fn(std::integral_constant<int, 15>{});
+	case 31: return fn(std::integral_constant<int, 31>{});
+	default: return fn(std::integral_constant<int, 0>{});
+	}
+}
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_WINDOWKERNEL_HPP
@@ -0,0 +1,32 @@
+#ifndef IMG_CLEAN_PROCESSORS_WOLFPROCESSOR_HPP
+#define IMG_CLEAN_PROCESSORS_WOLFPROCESSOR_HPP
+
+#include <imgclean/BinaryImage.hpp>
+#include <imgclean/GSImage.hpp>
+#include <imgclean/processors/BoxSumEngine.hpp>
+
+namespace imgclean::processors
+{
+//! Wolf-Jolion thresholding: T = m - k * (1 - s / R) * (m - M) with the local mean m and stddev s,
+//! the darkest pixel M of the image and the largest local stddev R of the image.
+//! Normalizing by the image instead of a fixed range adapts Sauvola to low-contrast scans.
+class WolfProcessor
+{
+public:
+	//! Default window size for the local statistics
+	static constexpr int default_window_size = 15;
+	//! Default sensitivity to the local contrast
+	static constexpr float default_k = 0.5f;
+
+	//! Binarizes the image, pixels below T become black
+	//! window_size must be odd (see is_valid_window_size), otherwise an empty image is returned
+	static GSImage apply(const GSImage& image, WindowEngine engine = WindowEngine::INTEGRAL_IMAGE,
+	                     int window_size = default_window_size, float k = default_k);
+
+	//! Same as apply, but writes the result bit-packed, pixels below T become ink
+	static BinaryImage apply_binary(const GSImage& image, WindowEngine engine = WindowEngine::INTEGRAL_IMAGE,
+	                                int window_size = default_window_size, float k = default_k);
+};
+} // namespace imgclean::processors
+
+#endif // IMG_CLEAN_PROCESSORS_WOLFPROCESSOR_HPP
@@ -1,13 +1,27 @@
 #include "imgclean/FileHandler.hpp"
 
-#include <algorithm>  // std::transform
+#include <algorithm>  // std::transform, std::copy, std::max_element, std::min, std::max
+#include <array>      // std::array
+#include <bit>        // std::countr_zero
 #include <cctype>     // std::tolower
 #include <charconv>   // std::from_chars, std::to_chars
-#include <cstring>    // std::memcpy
+#include <cstring>    // std::memcpy, std::memchr
 #include <filesystem> // std::filesystem
 #include <fstream>    // std::ifstream, std::ofstream
 #include <vector>     // std::vector
 
+#if defined(__SSE2__)
+# include <immintrin.h>
+#endif
+
+#if __has_include(<sys/mman.h>)
+# define IMGCLEAN_HAS_MMAP
+# include <fcntl.h>    // open
+# include <sys/mman.h> // mmap, munmap, madvise
+# include <sys/stat.h> // fstat
+# include <unistd.h>   // close
+#endif
+
 #ifdef CIMG_FOUND
 # define cimg_display 0 // we dont need to display images -> reduce dependencies
 # include <CImg.h>
@@ -21,135 +35,796 @@
 namespace imgclean
 {
 
-ImageFormat FileHandler::detect_format(const std::string& path)
+namespace
 {
-	auto dot = path.find_last_of('.');
-	if (dot == std::string::npos) return ImageFormat::UNKNOWN;
-	std::string ext = path.substr(dot + 1);
-	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
-	if (ext == "ppm") return ImageFormat::PPM_ASCII;
-	if (ext == "png") return ImageFormat::PNG;
-	if (ext == "jpg" || ext == "jpeg") return ImageFormat::JPG;
-	return ImageFormat::UNKNOWN;
+//! Creates the parent directory of path if it does not exist yet
+bool create_parent_directory(const std::string& path)
+{
+	std::filesystem::path file_path(path);
+	if (file_path.has_parent_path())
+	{
+		std::error_code ec;
+		const auto parent = file_path.parent_path();
+		if (!std::filesystem::exists(parent))
+		{
+			std::filesystem::create_directories(parent, ec);
+		}
+		if (ec) return false;
+	}
+	return true;
 }
 
-FilePath FileHandler::make_file_path(const std::string& path)
+//! Header: <magic>\n<width> <height>\n<maxval>\n
+void write_header(std::ofstream& file, const char* magic, int width, int height, int maxval)
 {
-	return FilePath{path, detect_format(path)};
+	const std::string header = std::string(magic, 2) + "\n" + std::to_string(width) + " " + std::to_string(height) +
+	                           "\n" + std::to_string(maxval) + "\n";
+	file.write(header.data(), static_cast<std::streamsize>(header.size()));
 }
 
-bool FileHandler::load_image(const FilePath& src, PPMImage& out)
+//! Decimal text of a number and its length, 8 bytes so that it is copied with one load and store
+struct DecimalText
 {
-	if (src.format == ImageFormat::UNKNOWN) return false;
+	char chars[7]  = {};
+	uint8_t length = 0;
+};
 
-	// Handle PPM_ASCII (P3) format manually
-	if (src.format == ImageFormat::PPM_ASCII)
+constexpr DecimalText decimal_text(uint32_t value)
+{
+	DecimalText text;
+	char reversed[7] = {};
+	do
+	{
+		reversed[text.length++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	for (int i = 0; i < text.length; ++i)
 	{
-		// get file size
-		const auto sz = std::filesystem::file_size(src.path);
-		if (sz == 0) return false;
+		text.chars[i] = reversed[text.length - 1 - i];
+	}
+	return text;
+}
 
-		// create buffer
-		std::string buf;
-		buf.resize(sz);
+constexpr std::array<DecimalText, 256> make_byte_text()
+{
+	std::array<DecimalText, 256> table{};
+	for (uint32_t value = 0; value < table.size(); ++value)
+	{
+		table[value] = decimal_text(value);
+	}
+	return table;
+}
 
-		// read file into buffer
-		std::ifstream file(src.path, std::ios::binary);
-		if (!file.read(buf.data(), sz)) return false;
+//! Text of 0 to 255, rendered at compile time
+constexpr std::array<DecimalText, 256> byte_text = make_byte_text();
 
-		const char* p   = buf.data();
-		const char* end = buf.data() + buf.size();
+//! Values per line of a P2 body: 17 values of up to 3 digits and their separators stay within the
+//! 70 characters per line that netpbm allows
+constexpr size_t gray_values_per_line = 17;
 
-		//! Helper function to skip whitespace and comments
-		auto skip_ws_and_comments = [](const char*& it, const char* it_end)
+//! Text of 0 to 65535, rendered for the first image with samples above 255
+const DecimalText* wide_text()
+{
+	static const std::vector<DecimalText> table = []
+	{
+		std::vector<DecimalText> text(65536);
+		for (uint32_t value = 0; value < text.size(); ++value)
+		{
+			text[value] = decimal_text(value);
+		}
+		return text;
+	}();
+	return table.data();
+}
+
+//! Appends the text of value to out and moves out behind it. Copies all 8 bytes of the entry, the
+//! buffer needs sizeof(DecimalText) bytes of slack behind the text
+inline void put_number(char*& out, const DecimalText* table, uint32_t value)
+{
+	std::memcpy(out, &table[value], sizeof(DecimalText));
+	out += table[value].length;
+}
+
+//! Writes the ASCII body of a netpbm file. Bands of rows are formatted into their own buffers in
+//! parallel, then the buffers are written in order, a round of bands at a time to bound the memory.
+//! format_row(y, out) writes row y to out and returns the end of its text, at most row_bytes long
+template <typename FormatRow>
+bool write_ascii_rows(std::ofstream& file, int height, size_t row_bytes, FormatRow format_row)
+{
+	constexpr size_t band_bytes   = size_t(1) << 20;
+	constexpr int bands_per_round = 16;
+	const int64_t band_rows       = static_cast<int64_t>(band_bytes / std::max<size_t>(1, row_bytes)) + 1;
+
+	std::vector<std::vector<char>> buffers(bands_per_round);
+	std::vector<size_t> lengths(bands_per_round);
+	for (int64_t round = 0; round < height; round += band_rows * bands_per_round)
+	{
+#pragma omp parallel for schedule(dynamic)
+		for (int b = 0; b < bands_per_round; ++b)
 		{
-			while (it < it_end)
+			const int64_t y_begin     = std::min<int64_t>(height, round + b * band_rows);
+			const int64_t y_end       = std::min<int64_t>(height, y_begin + band_rows);
+			std::vector<char>& buffer = buffers[b];
+			buffer.resize(static_cast<size_t>(y_end - y_begin) * row_bytes + sizeof(DecimalText));
+			char* out = buffer.data();
+			for (int64_t y = y_begin; y < y_end; ++y)
 			{
-				// Skip whitespace
-				while (it < it_end && static_cast<unsigned char>(*it) <= ' ')
-					++it;
-				if (it >= it_end) break;
-				if (*it == '#')
-				{
-					// Skip comment until end-of-line
-					while (it < it_end && *it != '\n' && *it != '\r')
-						++it;
-					continue;
-				}
-				break;
+				out = format_row(static_cast<int>(y), out);
 			}
-		};
+			lengths[b] = static_cast<size_t>(out - buffer.data());
+		}
 
-		//! Helper function to parse an integer
-		auto parse_int = [](const char*& it, const char* it_end, int& out_val) -> bool
+		for (int b = 0; b < bands_per_round; ++b)
 		{
-			std::from_chars_result res{nullptr, std::errc{}};
-			// parse base 10 integer from it to it_end
-			res = std::from_chars(it, it_end, out_val, 10);
-			// no char was consumed/parsed
-			if (res.ptr == it) return false;
-			// move iterator forward
-			it = res.ptr;
-			// true if no error occurred
-			return res.ec == std::errc{};
-		};
+			file.write(buffers[b].data(), static_cast<std::streamsize>(lengths[b]));
+		}
+	}
+	return file.good();
+}
 
-		// Parse magic number "P3"
-		skip_ws_and_comments(p, end);
-		if (p >= end || *p != 'P') return false;
-		++p;
-		if (p >= end || *p != '3') return false;
-		++p;
+//! Read-only view of a whole file. The file is memory-mapped where mmap is available, so the
+//! parsers read straight from the page cache, otherwise it is read into a buffer
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path)
+	{
+#ifdef IMGCLEAN_HAS_MMAP
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) return;
+		struct stat info;
+		if (::fstat(fd, &info) == 0 && info.st_size > 0)
+		{
+			void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapping != MAP_FAILED)
+			{
+				// the parsers walk the file front to back
+				::madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+				begin_ptr = static_cast<const char*>(mapping);
+				length    = static_cast<size_t>(info.st_size);
+			}
+		}
+		// the mapping stays valid after the descriptor is closed
+		::close(fd);
+#else
+		std::error_code ec;
+		const auto sz = std::filesystem::file_size(path, ec);
+		if (ec || sz == 0) return;
+		buffer.resize(sz);
+		std::ifstream file(path, std::ios::binary);
+		if (!file.read(buffer.data(), static_cast<std::streamsize>(sz))) return;
+		begin_ptr = buffer.data();
+		length    = buffer.size();
+#endif
+	}
 
-		// Parse width, height, maxval
-		skip_ws_and_comments(p, end);
-		int header_w = 0;
-		if (!parse_int(p, end, header_w)) return false;
+	~MappedFile()
+	{
+#ifdef IMGCLEAN_HAS_MMAP
+		if (begin_ptr != nullptr) ::munmap(const_cast<char*>(begin_ptr), length);
+#endif
+	}
 
-		skip_ws_and_comments(p, end);
-		int header_h = 0;
-		if (!parse_int(p, end, header_h)) return false;
+	MappedFile(const MappedFile&)            = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool valid() const { return begin_ptr != nullptr; }
+	const char* begin() const { return begin_ptr; }
+	const char* end() const { return begin_ptr + length; }
+
+private:
+	const char* begin_ptr = nullptr;
+	size_t length         = 0;
+#ifndef IMGCLEAN_HAS_MMAP
+	std::vector<char> buffer;
+#endif
+};
+
+//! Skips whitespace and comments
+void skip_ws_and_comments(const char*& it, const char* it_end)
+{
+	while (it < it_end)
+	{
+		// Skip whitespace
+		while (it < it_end && static_cast<unsigned char>(*it) <= ' ')
+			++it;
+		if (it >= it_end) break;
+		if (*it == '#')
+		{
+			// Skip comment until end-of-line
+			while (it < it_end && *it != '\n' && *it != '\r')
+				++it;
+			continue;
+		}
+		break;
+	}
+}
+
+//! Parses a base 10 integer and moves it past it
+bool parse_int(const char*& it, const char* it_end, int& out_val)
+{
+	std::from_chars_result res{nullptr, std::errc{}};
+	// parse base 10 integer from it to it_end
+	res = std::from_chars(it, it_end, out_val, 10);
+	// no char was consumed/parsed
+	if (res.ptr == it) return false;
+	// move iterator forward
+	it = res.ptr;
+	// true if no error occurred
+	return res.ec == std::errc{};
+}
+
+//! Netpbm header: magic number, width, height and maxval
+struct NetpbmHeader
+{
+	char magic = 0; // the digit after 'P'
+	int width  = 0;
+	int height = 0;
+	int maxval = 0;
+};
+
+//! Parses the header and leaves p on the whitespace character that ends it
+bool parse_header(const char*& p, const char* end, NetpbmHeader& header)
+{
+	skip_ws_and_comments(p, end);
+	if (end - p < 2 || p[0] != 'P') return false;
+	header.magic = p[1];
+	p += 2;
+
+	skip_ws_and_comments(p, end);
+	if (!parse_int(p, end, header.width)) return false;
+	skip_ws_and_comments(p, end);
+	if (!parse_int(p, end, header.height)) return false;
+	skip_ws_and_comments(p, end);
+	if (!parse_int(p, end, header.maxval)) return false;
+
+	return header.width > 0 && header.height > 0 && header.maxval > 0 && header.maxval <= 65535;
+}
 
+//! Bytes of P3 text per parser chunk
+constexpr size_t ascii_chunk_size = size_t(1) << 20;
+
+bool is_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+//! Splits the P3 body into chunks that start on whitespace boundaries. Comments run to the end of
+//! the line, so with comments in the body the chunks start behind a line break
+std::vector<const char*> split_ascii_body(const char* p, const char* end)
+{
+	const bool has_comments = std::memchr(p, '#', static_cast<size_t>(end - p)) != nullptr;
+	std::vector<const char*> bounds{p};
+	while (static_cast<size_t>(end - bounds.back()) > ascii_chunk_size)
+	{
+		const char* it = bounds.back() + ascii_chunk_size;
+		while (it < end && (has_comments ? it[-1] != '\n' : static_cast<unsigned char>(it[-1]) > ' '))
+			++it;
+		bounds.push_back(it);
+	}
+	if (bounds.back() != end) bounds.push_back(end);
+	return bounds;
+}
+
+//! Counts the numbers the parse loop reads from [p, end): a minus sign and digits, or digits.
+//! Stops at the first character that cannot start a number and sets invalid, the loop stops there too
+size_t count_tokens(const char* p, const char* end, bool& invalid)
+{
+	size_t count = 0;
+	invalid      = false;
+	while (true)
+	{
 		skip_ws_and_comments(p, end);
-		int header_max = 0;
-		if (!parse_int(p, end, header_max)) return false;
+		if (p >= end) return count;
+		const char* digits = *p == '-' ? p + 1 : p;
+		if (digits >= end || !is_digit(*digits))
+		{
+			invalid = true;
+			return count;
+		}
+		p = digits;
+		while (p < end && is_digit(*p))
+			++p;
+		++count;
+	}
+}
 
-		if (header_w <= 0 || header_h <= 0 || header_max <= 0) return false;
+//! Counts the numbers of a comment-free chunk that holds nothing but digits and whitespace, the common
+//! case. Branch-free, so it vectorizes. False if anything else shows up, count_tokens handles that
+bool count_plain_tokens(const char* p, const char* end, size_t& count)
+{
+	// the chunk starts behind whitespace
+	const auto* bytes = reinterpret_cast<const uint8_t*>(p);
+	const size_t size = static_cast<size_t>(end - p);
+	if (size == 0)
+	{
+		count = 0;
+		return true;
+	}
+	size_t starts  = bytes[0] > ' ';
+	uint32_t other = static_cast<uint8_t>(bytes[0] - '0') >= 10 && bytes[0] > ' ';
+	for (size_t i = 1; i < size; ++i)
+	{
+		const uint8_t c = bytes[i];
+		starts += (bytes[i - 1] <= ' ') & (c > ' ');
+		other |= (c > ' ') & (static_cast<uint8_t>(c - '0') >= 10);
+	}
+	count = starts;
+	return other == 0;
+}
 
-		out.width  = header_w;
-		out.height = header_h;
-		out.maxval = header_max;
+//! Bit i is set if byte i of the 64 bytes at p is a digit. Only for plain chunks, where every byte is
+//! either whitespace (at most ' ') or a digit, so one compare against '0' - 1 tells them apart
+inline uint64_t digit_mask(const uint8_t* p)
+{
+#if defined(__AVX2__)
+	const __m256i separator = _mm256_set1_epi8('0' - 1);
+	const __m256i lo        = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+	const __m256i hi        = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+	const uint32_t lo_mask  = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(lo, separator)));
+	const uint32_t hi_mask  = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(hi, separator)));
+	return static_cast<uint64_t>(hi_mask) << 32 | lo_mask;
+#elif defined(__SSE2__)
+	const __m128i separator = _mm_set1_epi8('0' - 1);
+	uint64_t mask           = 0;
+	for (int k = 0; k < 64; k += 16)
+	{
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k));
+		const uint64_t bits = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(bytes, separator)));
+		mask |= bits << k;
+	}
+	return mask;
+#else
+	uint64_t mask = 0;
+	for (int k = 0; k < 64; ++k)
+	{
+		mask |= static_cast<uint64_t>(p[k] >= '0') << k;
+	}
+	return mask;
+#endif
+}
 
-		const size_t pixel_count = static_cast<size_t>(out.width) * static_cast<size_t>(out.height) * 3u;
-		out.pixels.resize(pixel_count);
+//! Digits a number may have to be converted from the digit vectors, longer ones go through from_chars
+constexpr int vector_digits = 5;
+constexpr int16_t powers_of_ten[vector_digits - 1] = {1, 10, 100, 1000};
+
+//! For every byte of the 64 bytes at p, the number of at most 5 digits that ends in it: the last four
+//! digits in low, the fifth from the end in high. Bytes are compared against '0' one to four positions
+//! back, so each digit is multiplied and added in without a dependency on the other positions. Only the
+//! entries at the last digit of a number are meaningful. Reads up to 4 bytes before p
+inline void digit_values(const uint8_t* p, uint16_t* low, uint16_t* high)
+{
+#if defined(__AVX2__)
+	const __m256i zero  = _mm256_set1_epi16('0');
+	const __m256i below = _mm256_set1_epi16('0' - 1);
+	for (int k = 0; k < 64; k += 16)
+	{
+		// digit i positions back, and whether the run of digits reaches back that far
+		__m256i run   = _mm256_set1_epi16(-1);
+		__m256i value = _mm256_setzero_si256();
+		__m256i fifth = _mm256_setzero_si256();
+		for (int i = 0; i < vector_digits; ++i)
+		{
+			const __m256i bytes = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k - i)));
+			run                 = _mm256_and_si256(run, _mm256_cmpgt_epi16(bytes, below));
+			const __m256i digit = _mm256_and_si256(run, _mm256_sub_epi16(bytes, zero));
+			if (i + 1 < vector_digits)
+			{
+				value = _mm256_add_epi16(value, _mm256_mullo_epi16(digit, _mm256_set1_epi16(powers_of_ten[i])));
+			}
+			else
+			{
+				fifth = digit;
+			}
+		}
+		_mm256_store_si256(reinterpret_cast<__m256i*>(low + k), value);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(high + k), fifth);
+	}
+#elif defined(__SSE2__)
+	const __m128i zero  = _mm_set1_epi16('0');
+	const __m128i below = _mm_set1_epi16('0' - 1);
+	const __m128i none  = _mm_setzero_si128();
+	for (int k = 0; k < 64; k += 8)
+	{
+		__m128i run   = _mm_set1_epi16(-1);
+		__m128i value = _mm_setzero_si128();
+		__m128i fifth = _mm_setzero_si128();
+		for (int i = 0; i < vector_digits; ++i)
+		{
+			const __m128i bytes =
+				_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + k - i)), none);
+			run                 = _mm_and_si128(run, _mm_cmpgt_epi16(bytes, below));
+			const __m128i digit = _mm_and_si128(run, _mm_sub_epi16(bytes, zero));
+			if (i + 1 < vector_digits)
+			{
+				value = _mm_add_epi16(value, _mm_mullo_epi16(digit, _mm_set1_epi16(powers_of_ten[i])));
+			}
+			else
+			{
+				fifth = digit;
+			}
+		}
+		_mm_store_si128(reinterpret_cast<__m128i*>(low + k), value);
+		_mm_store_si128(reinterpret_cast<__m128i*>(high + k), fifth);
+	}
+#else
+	for (int k = 0; k < 64; ++k)
+	{
+		uint32_t value = 0;
+		bool run       = true;
+		high[k]        = 0;
+		for (int i = 0; i < vector_digits; ++i)
+		{
+			run = run && p[k - i] >= '0';
+			if (!run) break;
+			if (i + 1 < vector_digits)
+			{
+				value += (p[k - i] - '0') * powers_of_ten[i];
+			}
+			else
+			{
+				high[k] = static_cast<uint16_t>(p[k - i] - '0');
+			}
+		}
+		low[k] = static_cast<uint16_t>(value);
+	}
+#endif
+}
 
-		// Parse pixel data
-		size_t idx    = 0;
-		uint16_t* dst = out.pixels.data();
+//! Parses the numbers of a plain chunk into dst[idx, stop). Blocks of 64 bytes are classified at once,
+//! the values come from digit_values and are picked up at the last digit of every number. Numbers of
+//! more than 5 digits (leading zeros, or too large) are left to from_chars. The rest of the chunk that
+//! does not fill two blocks takes the scalar loop.
+//! The chunk starts behind whitespace, the bytes digit_values reads before it belong to the header or
+//! the previous chunk and never count
+bool parse_plain_chunk(const char* p, const char* end, uint16_t* dst, size_t idx, size_t stop, int max)
+{
+	const auto* bytes = reinterpret_cast<const uint8_t*>(p);
+	const size_t size = static_cast<size_t>(end - p);
+	alignas(32) uint16_t low[64];
+	alignas(32) uint16_t high[64];
+	size_t next       = 0; // behind the last number
+	uint64_t previous = 0;
+	uint64_t digits   = size >= 64 ? digit_mask(bytes) : 0;
+	// the block behind is needed to tell where the numbers end
+	for (size_t block = 0; block + 128 <= size && idx < stop; block += 64)
+	{
+		const uint64_t following = digit_mask(bytes + block + 64);
+		const uint64_t ends      = digits & ~(digits >> 1 | following << 63);
+		// set at the 5th and at the 6th digit of a number and behind
+		uint64_t fifth_digits = digits;
+		for (int i = 1; i < vector_digits; ++i)
+		{
+			fifth_digits &= digits << i | previous >> (64 - i);
+		}
+		const uint64_t long_runs = fifth_digits & (digits << vector_digits | previous >> (64 - vector_digits));
+		digit_values(bytes + block, low, high);
 
-		while (idx < pixel_count)
+		bool above       = false;
+		const auto count = static_cast<size_t>(std::popcount(ends));
+		if ((ends & fifth_digits) == 0 && idx + count <= stop)
 		{
-			skip_ws_and_comments(p, end);
-			if (p >= end) break;
+			// the common case, every number of the block is in low
+			for (uint64_t e = ends; e != 0; e &= e - 1)
+			{
+				const uint16_t value = low[std::countr_zero(e)];
+				above |= value > max;
+				dst[idx++] = value;
+			}
+			if (ends != 0) next = block + 64 - static_cast<size_t>(std::countl_zero(ends));
+		}
+		else
+		{
+			for (uint64_t e = ends; e != 0 && idx < stop; e &= e - 1)
+			{
+				const int k    = std::countr_zero(e);
+				uint32_t value = low[k] + 10000u * high[k];
+				if (long_runs >> k & 1)
+				{
+					size_t begin = block + k;
+					while (begin > 0 && is_digit(p[begin - 1]))
+						--begin;
+					const char* it = p + begin;
+					int long_value = 0;
+					if (!parse_int(it, end, long_value)) return false;
+					value = static_cast<uint32_t>(long_value);
+				}
+				above |= value > static_cast<uint32_t>(max);
+				dst[idx++] = static_cast<uint16_t>(value);
+				next       = block + k + 1;
+			}
+		}
+		if (above) return false;
+		previous = digits;
+		digits   = following;
+	}
+
+	// a number may run past the last block, continue behind the last one picked up
+	const char* it = p + next;
+	for (; idx < stop; ++idx)
+	{
+		skip_ws_and_comments(it, end);
+		int value = 0;
+		if (!parse_int(it, end, value) || value < 0 || value > max) return false;
+		dst[idx] = static_cast<uint16_t>(value);
+	}
+	return true;
+}
+
+//! Parses the ASCII P3 body. A first pass counts the numbers of every chunk to find where the chunk
+//! writes, then the chunks are parsed in parallel
+bool parse_ascii_ppm(const char* p, const char* end, PPMImage& out)
+{
+	const size_t pixel_count = out.pixel_count() * 3u;
+	out.pixels.resize(pixel_count);
+
+	const std::vector<const char*> bounds = split_ascii_body(p, end);
+	const int num_chunks                  = static_cast<int>(bounds.size()) - 1;
+	std::vector<size_t> offsets(bounds.size(), 0);
+	std::vector<uint8_t> invalid(bounds.size(), 0);
+	std::vector<uint8_t> plain(bounds.size(), 0);
+
+#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < num_chunks; ++c)
+	{
+		size_t count = 0;
+		if (count_plain_tokens(bounds[c], bounds[c + 1], count))
+		{
+			offsets[c + 1] = count;
+			plain[c]       = 1;
+			continue;
+		}
+		bool chunk_invalid = false;
+		offsets[c + 1]     = count_tokens(bounds[c], bounds[c + 1], chunk_invalid);
+		invalid[c]         = chunk_invalid;
+	}
+
+	// prefix sum, a token that is no number fails the image unless all pixels come before it
+	for (int c = 0; c < num_chunks; ++c)
+	{
+		offsets[c + 1] += offsets[c];
+		if (invalid[c] && offsets[c + 1] < pixel_count) return false;
+	}
+	if (offsets[num_chunks] < pixel_count) return false;
 
+	// Parse pixel data, numbers behind the last pixel are ignored
+	uint16_t* dst   = out.pixels.data();
+	const int max   = out.maxval;
+	bool all_parsed = true;
+
+#pragma omp parallel for schedule(dynamic) reduction(&& : all_parsed)
+	for (int c = 0; c < num_chunks; ++c)
+	{
+		const char* it        = bounds[c];
+		const char* chunk_end = bounds[c + 1];
+		const size_t stop     = std::min(offsets[c + 1], pixel_count);
+		if (offsets[c] >= stop) continue;
+		// chunks with comments or anything else but digits and whitespace take the scalar loop
+		if (plain[c])
+		{
+			all_parsed = all_parsed && parse_plain_chunk(it, chunk_end, dst, offsets[c], stop, max);
+			continue;
+		}
+		for (size_t idx = offsets[c]; idx < stop; ++idx)
+		{
+			skip_ws_and_comments(it, chunk_end);
 			int value = 0;
-			if (!parse_int(p, end, value)) break;
-			if (value < 0 || value > out.maxval || value > 65535)
+			if (!parse_int(it, chunk_end, value) || value < 0 || value > max)
 			{
-				out.clear();
-				return false;
+				all_parsed = false;
+				break;
 			}
-			dst[idx++] = static_cast<uint16_t>(value);
+			dst[idx] = static_cast<uint16_t>(value);
 		}
+	}
+
+	return all_parsed;
+}
+
+//! Converts the raw P5/P6 body: one byte per sample up to maxval 255, two big-endian bytes above.
+//! P5 gray values are repeated for R, G and B
+bool convert_binary_netpbm(const char* p, const char* end, int channels, PPMImage& out)
+{
+	const size_t sample_bytes = out.maxval > 255 ? 2 : 1;
+	const size_t row_samples  = static_cast<size_t>(out.width) * channels;
+	const size_t row_bytes    = row_samples * sample_bytes;
+	if (static_cast<size_t>(end - p) < row_bytes * out.height) return false;
+
+	out.pixels.resize(out.pixel_count() * 3u);
+	const auto* data = reinterpret_cast<const uint8_t*>(p);
+	const int maxval = out.maxval;
+	bool in_range    = true;
+
+#pragma omp parallel for schedule(static) reduction(&& : in_range)
+	for (int y = 0; y < out.height; ++y)
+	{
+		const uint8_t* src = data + static_cast<size_t>(y) * row_bytes;
+		uint16_t* dst      = out.pixels.data() + static_cast<size_t>(y) * out.width * 3;
+		if (sample_bytes == 1)
+		{
+			// a byte cannot exceed the common maxval 255, only smaller ones need the check
+			if (maxval < 255)
+			{
+				in_range = in_range && *std::max_element(src, src + row_samples) <= maxval;
+			}
+			if (channels == 3)
+			{
+				std::copy(src, src + row_samples, dst);
+			}
+			else
+			{
+				for (int x = 0; x < out.width; ++x)
+				{
+					dst[3 * x + 0] = dst[3 * x + 1] = dst[3 * x + 2] = src[x];
+				}
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < row_samples; ++i)
+			{
+				const uint16_t value = static_cast<uint16_t>((src[2 * i] << 8) | src[2 * i + 1]);
+				in_range             = in_range && value <= maxval;
+				if (channels == 3)
+				{
+					dst[i] = value;
+				}
+				else
+				{
+					dst[3 * i + 0] = dst[3 * i + 1] = dst[3 * i + 2] = value;
+				}
+			}
+		}
+	}
+
+	return in_range;
+}
+
+//! Loads a P3, P5 or P6 file, the magic number in the file decides how the body is read
+bool load_netpbm(const std::string& path, PPMImage& out)
+{
+	const MappedFile file(path);
+	if (!file.valid()) return false;
+
+	const char* p   = file.begin();
+	const char* end = file.end();
+	NetpbmHeader header;
+	if (!parse_header(p, end, header)) return false;
+
+	out.width  = header.width;
+	out.height = header.height;
+	out.maxval = header.maxval;
+
+	bool success = false;
+	if (header.magic == '3')
+	{
+		success = parse_ascii_ppm(p, end, out);
+	}
+	else if (header.magic == '5' || header.magic == '6')
+	{
+		// exactly one whitespace character separates maxval from the raw samples
+		success = p < end && static_cast<unsigned char>(*p) <= ' ' &&
+		          convert_binary_netpbm(p + 1, end, header.magic == '6' ? 3 : 1, out);
+	}
+	// no P2 reader yet
 
-		if (idx != pixel_count)
+	if (!success) out.clear();
+	return success;
+}
+
+//! Writes the raw P6 body of an RGB image, big-endian 16-bit samples if maxval is above 255
+void write_binary_ppm(std::ofstream& file, const PPMImage& img)
+{
+	const size_t row_samples  = static_cast<size_t>(img.width) * 3;
+	const size_t sample_bytes = img.maxval > 255 ? 2 : 1;
+	std::vector<char> row(row_samples * sample_bytes);
+	for (int y = 0; y < img.height; ++y)
+	{
+		const uint16_t* src = img.pixels.data() + static_cast<size_t>(y) * row_samples;
+		for (size_t i = 0; i < row_samples; ++i)
 		{
-			out.clear();
-			return false;
+			if (sample_bytes == 1)
+			{
+				row[i] = static_cast<char>(src[i]);
+			}
+			else
+			{
+				row[2 * i]     = static_cast<char>(src[i] >> 8);
+				row[2 * i + 1] = static_cast<char>(src[i] & 0xFF);
+			}
 		}
+		file.write(row.data(), static_cast<std::streamsize>(row.size()));
+	}
+}
 
+#ifdef CIMG_FOUND
+//! Saves a PNG or JPG through CImg, EXIF data is injected into JPGs if supported
+bool save_cimg(const FilePath& dst, const cimg_library::CImg<unsigned char>& cimg,
+               const std::vector<unsigned char>& exif_data)
+{
+# ifdef EXIF_FOUND
+	// If JPG and exif_data present in img, inject EXIF
+	if (dst.format == ImageFormat::JPG && !exif_data.empty())
+	{
+		// Save image to temp file first
+		std::string tmp_path = dst.path + ".tmp.jpg";
+		cimg.save(tmp_path.c_str());
+
+		// Read temp file
+		std::ifstream in(tmp_path, std::ios::binary);
+		std::ofstream out(dst.path, std::ios::binary);
+		if (in && out)
+		{
+			// Write SOI marker
+			unsigned char marker[2];
+			in.read(reinterpret_cast<char*>(marker), 2);
+			out.write(reinterpret_cast<char*>(marker), 2);
+			// Write EXIF segment
+			out.put(0xFF);
+			out.put(0xE1); // APP1 marker
+			uint16_t exif_len = static_cast<uint16_t>(exif_data.size() + 2);
+			out.put((exif_len >> 8) & 0xFF);
+			out.put(exif_len & 0xFF);
+			out.write(reinterpret_cast<const char*>(exif_data.data()), exif_data.size());
+			// Copy rest of file
+			out << in.rdbuf();
+		}
+		in.close();
+		out.close();
+		std::filesystem::remove(tmp_path);
 		return true;
 	}
+	else
+	{
+		// No EXIF data, just save
+		cimg.save(dst.path.c_str());
+		return true;
+	}
+# else
+	// No EXIF support, just save
+	(void)exif_data;
+	cimg.save(dst.path.c_str());
+	return true;
+# endif
+}
+#endif // CIMG_FOUND
+} // namespace
+
+ImageFormat FileHandler::detect_format(const std::string& path)
+{
+	auto dot = path.find_last_of('.');
+	if (dot == std::string::npos) return ImageFormat::UNKNOWN;
+	std::string ext = path.substr(dot + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+	if (ext == "png") return ImageFormat::PNG;
+	if (ext == "jpg" || ext == "jpeg") return ImageFormat::JPG;
+	if (ext != "ppm" && ext != "pgm" && ext != "pnm") return ImageFormat::UNKNOWN;
+
+	// the extension only picks the variant written, loading reads the magic number of the file
+	if (ext == "ppm") return ImageFormat::PPM_ASCII;
+	if (ext == "pgm") return ImageFormat::PGM_BINARY;
+	return ImageFormat::PPM_BINARY;
+}
+
+FilePath FileHandler::make_file_path(const std::string& path, bool plain, bool binary)
+{
+	ImageFormat format = detect_format(path);
+	if (plain && format == ImageFormat::PGM_BINARY) format = ImageFormat::PGM_ASCII;
+	if (plain && format == ImageFormat::PPM_BINARY) format = ImageFormat::PPM_ASCII;
+	if (binary && !plain && format == ImageFormat::PPM_ASCII) format = ImageFormat::PPM_BINARY;
+	return FilePath{path, format};
+}
+
+bool FileHandler::load_image(const FilePath& src, PPMImage& out)
+{
+	if (src.format == ImageFormat::UNKNOWN) return false;
+
+	// Handle the netpbm formats manually
+	if (src.format == ImageFormat::PPM_ASCII || src.format == ImageFormat::PPM_BINARY ||
+	    src.format == ImageFormat::PGM_ASCII || src.format == ImageFormat::PGM_BINARY)
+	{
+		return load_netpbm(src.path, out);
+	}
 
 #ifdef CIMG_FOUND
 	// Handle PNG and JPG formats using CImg
@@ -159,9 +834,13 @@ bool FileHandler::load_image(const FilePath& src, PPMImage& out)
 		out.width                = img.width();
 		out.height               = img.height();
 		out.maxval               = 255;
-		const size_t pixel_count = static_cast<size_t>(out.width) * static_cast<size_t>(out.height) * 3u;
+		const size_t pixel_count = out.pixel_count() * 3u;
 		out.pixels.resize(pixel_count);
 
+		// grayscale files (with or without alpha) have fewer than 3 channels -> replicate channel 0
+		const int g_channel = img.spectrum() >= 3 ? 1 : 0;
+		const int b_channel = img.spectrum() >= 3 ? 2 : 0;
+
 # pragma omp parallel for collapse(2)
 		for (int y = 0; y < out.height; ++y)
 		{
@@ -169,10 +848,10 @@ bool FileHandler::load_image(const FilePath& src, PPMImage& out)
 			{
 				// in PPM, pixels are stored like R,G,B,R,G,B,...
 				// Access in img: x, y, depth, channel
-				size_t idx          = (y * out.width + x) * 3;
-				out.pixels[idx + 0] = img(x, y, 0, 0); // R
-				out.pixels[idx + 1] = img(x, y, 0, 1); // G
-				out.pixels[idx + 2] = img(x, y, 0, 2); // B
+				size_t idx          = (static_cast<size_t>(y) * out.width + x) * 3;
+				out.pixels[idx + 0] = img(x, y, 0, 0);         // R
+				out.pixels[idx + 1] = img(x, y, 0, g_channel); // G
+				out.pixels[idx + 2] = img(x, y, 0, b_channel); // B
 			}
 		}
 
@@ -222,19 +901,9 @@ bool FileHandler::load_image(const FilePath& src, PPMImage& out)
 bool FileHandler::save_image(const FilePath& dst, const PPMImage& img)
 {
 	if (dst.format == ImageFormat::UNKNOWN) return false;
-
-	// create output directory if it doesnt exist
-	std::filesystem::path file_path(dst.path);
-	if (file_path.has_parent_path())
-	{
-		std::error_code ec;
-		const auto parent = file_path.parent_path();
-		if (!std::filesystem::exists(parent))
-		{
-			std::filesystem::create_directories(parent, ec);
-		}
-		if (ec) return false;
-	}
+	// PGM holds a single channel, save a GSImage instead
+	if (dst.format == ImageFormat::PGM_ASCII || dst.format == ImageFormat::PGM_BINARY) return false;
+	if (!create_parent_directory(dst.path)) return false;
 
 	// Handle PPM_ASCII (P3) format manually
 	if (dst.format == ImageFormat::PPM_ASCII)
@@ -242,83 +911,47 @@ bool FileHandler::save_image(const FilePath& dst, const PPMImage& img)
 		std::ofstream file(dst.path, std::ios::binary);
 		if (!file.is_open()) return false;
 
-		// 1 MiB buffer
-		constexpr size_t kBufCap = 1u << 20;
-		std::vector<char> buf;
-		buf.resize(kBufCap);
-		size_t pos = 0;
-
-		//! Helper function to flush buffer to file
-		auto flush = [&]()
-		{
-			if (pos)
-			{
-				file.write(buf.data(), static_cast<std::streamsize>(pos));
-				pos = 0;
-			}
-		};
-
-		//! Helper function to ensure there is enough space in buffer, flushing if necessary
-		auto ensure = [&](size_t need)
-		{
-			if (pos + need > buf.size()) flush();
-		};
+		// Header: P3\n<width> <height>\n<maxval>\n
+		write_header(file, "P3", img.width, img.height, img.maxval);
 
-		//! Helper function to push data into buffer
-		auto push_char = [&](char c)
+		// samples above 255 need the 16-bit table, even in an image that claims a smaller maxval
+		uint16_t max_sample = 0;
+#pragma omp parallel for reduction(max : max_sample)
+		for (size_t i = 0; i < img.pixels.size(); ++i)
 		{
-			ensure(1);
-			buf[pos++] = c;
-		};
+			max_sample = std::max(max_sample, img.pixels[i]);
+		}
+		const bool wide           = max_sample > 255;
+		const DecimalText* table  = wide ? wide_text() : byte_text.data();
+		const size_t sample_bytes = wide ? 6 : 4;
 
-		//! Helper function to push multiple chars into buffer
-		auto push_chars = [&](const char* p, size_t n)
+		// Body: each pixel as "R G B\n"
+		const size_t width    = static_cast<size_t>(img.width);
+		const auto format_row = [&](int y, char* out)
 		{
-			// more chars than buffer size ->
-			// write directly, but that should not happen here anyway
-			if (n > buf.size())
+			const uint16_t* px = img.pixels.data() + static_cast<size_t>(y) * width * 3;
+			for (size_t x = 0; x < width; ++x, px += 3)
 			{
-				flush();
-				file.write(p, static_cast<std::streamsize>(n));
-				return;
+				put_number(out, table, px[0]);
+				*out++ = ' ';
+				put_number(out, table, px[1]);
+				*out++ = ' ';
+				put_number(out, table, px[2]);
+				*out++ = '\n';
 			}
-			if (pos + n > buf.size()) flush();
-			std::memcpy(buf.data() + pos, p, n);
-			pos += n;
-		};
-
-		//! Helper function to push an integer into buffer
-		auto push_int = [&](uint16_t v)
-		{
-			char tmp[6]; // max 5 digits for 65535 + NUL
-			// convert integer to chars without NUL termination
-			auto res = std::to_chars(tmp, tmp + sizeof(tmp), v, 10);
-			push_chars(tmp, static_cast<size_t>(res.ptr - tmp));
+			return out;
 		};
+		return write_ascii_rows(file, img.height, width * 3 * sample_bytes, format_row);
+	}
 
-		// Header: P3\n<width> <height>\n<maxval>\n
-		push_chars("P3\n", 3);
-		push_int(static_cast<uint16_t>(img.width));
-		push_char(' ');
-		push_int(static_cast<uint16_t>(img.height));
-		push_char('\n');
-		push_int(static_cast<uint16_t>(img.maxval));
-		push_char('\n');
-
-		// Body: each pixel as "R G B\n"
-		const uint16_t* px       = img.pixels.data();
-		const size_t pixel_count = static_cast<size_t>(img.width) * static_cast<size_t>(img.height) * 3u;
-		for (size_t i = 0; i < pixel_count; i += 3)
-		{
-			push_int(px[i + 0]);
-			push_char(' ');
-			push_int(px[i + 1]);
-			push_char(' ');
-			push_int(px[i + 2]);
-			push_char('\n');
-		}
+	if (dst.format == ImageFormat::PPM_BINARY)
+	{
+		std::ofstream file(dst.path, std::ios::binary);
+		if (!file.is_open()) return false;
 
-		flush();
+		// Header: P6\n<width> <height>\n<maxval>\n, then the raw samples
+		write_header(file, "P6", img.width, img.height, img.maxval);
+		write_binary_ppm(file, img);
 		return file.good();
 	}
 
@@ -335,56 +968,105 @@ bool FileHandler::save_image(const FilePath& dst, const PPMImage& img)
 			{
 				// in PPM, pixels are stored like R,G,B,R,G,B,...
 				// Access in img: x, y, depth, channel
-				size_t idx       = (y * img.width + x) * 3;
+				size_t idx       = (static_cast<size_t>(y) * img.width + x) * 3;
 				cimg(x, y, 0, 0) = static_cast<unsigned char>(img.pixels[idx + 0]); // R
 				cimg(x, y, 0, 1) = static_cast<unsigned char>(img.pixels[idx + 1]); // G
 				cimg(x, y, 0, 2) = static_cast<unsigned char>(img.pixels[idx + 2]); // B
 			}
 		}
 
-# ifdef EXIF_FOUND
-		// If JPG and exif_data present in img, inject EXIF
-		if (dst.format == ImageFormat::JPG && !img.exif_data.empty())
+		return save_cimg(dst, cimg, img.exif_data);
+	}
+	catch (const cimg_library::CImgException&)
+	{
+		return false;
+	}
+#else
+	return false;
+#endif
+}
+
+bool FileHandler::save_image(const FilePath& dst, const GSImage& img)
+{
+	if (dst.format == ImageFormat::UNKNOWN) return false;
+	if (!create_parent_directory(dst.path)) return false;
+
+	// Handle the netpbm formats manually
+	if (dst.format == ImageFormat::PGM_BINARY)
+	{
+		std::ofstream file(dst.path, std::ios::binary);
+		if (!file.is_open()) return false;
+
+		// Header: P5\n<width> <height>\n<maxval>\n, then one byte per pixel
+		write_header(file, "P5", img.width, img.height, img.maxval);
+		file.write(reinterpret_cast<const char*>(img.pixels.data()),
+		           static_cast<std::streamsize>(img.pixels.size()));
+		return file.good();
+	}
+
+	if (dst.format == ImageFormat::PPM_BINARY)
+	{
+		std::ofstream file(dst.path, std::ios::binary);
+		if (!file.is_open()) return false;
+
+		// P6 repeats the gray value for R, G and B, one row at a time
+		write_header(file, "P6", img.width, img.height, img.maxval);
+		std::vector<char> row(static_cast<size_t>(img.width) * 3);
+		for (int y = 0; y < img.height; ++y)
 		{
-			// Save image to temp file first
-			std::string tmp_path = dst.path + ".tmp.jpg";
-			cimg.save(tmp_path.c_str());
-
-			// Read temp file
-			std::ifstream in(tmp_path, std::ios::binary);
-			std::ofstream out(dst.path, std::ios::binary);
-			if (in && out)
+			const uint8_t* px = img.pixels.data() + static_cast<size_t>(y) * img.width;
+			for (int x = 0; x < img.width; ++x)
 			{
-				// Write SOI marker
-				unsigned char marker[2];
-				in.read(reinterpret_cast<char*>(marker), 2);
-				out.write(reinterpret_cast<char*>(marker), 2);
-				// Write EXIF segment
-				out.put(0xFF);
-				out.put(0xE1); // APP1 marker
-				uint16_t exif_len = static_cast<uint16_t>(img.exif_data.size() + 2);
-				out.put((exif_len >> 8) & 0xFF);
-				out.put(exif_len & 0xFF);
-				out.write(reinterpret_cast<const char*>(img.exif_data.data()), img.exif_data.size());
-				// Copy rest of file
-				out << in.rdbuf();
+				row[3 * x + 0] = row[3 * x + 1] = row[3 * x + 2] = static_cast<char>(px[x]);
 			}
-			in.close();
-			out.close();
-			std::filesystem::remove(tmp_path);
-			return true;
+			file.write(row.data(), static_cast<std::streamsize>(row.size()));
 		}
-		else
+		return file.good();
+	}
+
+	if (dst.format == ImageFormat::PGM_ASCII || dst.format == ImageFormat::PPM_ASCII)
+	{
+		std::ofstream file(dst.path, std::ios::binary);
+		if (!file.is_open()) return false;
+
+		// P3 repeats the gray value for R, G and B, there is no intermediate RGB image
+		const bool rgb = dst.format == ImageFormat::PPM_ASCII;
+		write_header(file, rgb ? "P3" : "P2", img.width, img.height, img.maxval);
+
+		// Body: "R G B\n" per pixel for P3, one line per image row for P2
+		const DecimalText* table = byte_text.data();
+		const size_t width       = static_cast<size_t>(img.width);
+		const auto format_row    = [&](int y, char* out)
 		{
-			// No EXIF data, just save
-			cimg.save(dst.path.c_str());
-			return true;
-		}
-# else
-		// No EXIF support, just save
-		cimg.save(dst.path.c_str());
-		return true;
-# endif
+			const uint8_t* px = img.pixels.data() + static_cast<size_t>(y) * width;
+			for (size_t x = 0; x < width; ++x)
+			{
+				put_number(out, table, px[x]);
+				if (rgb)
+				{
+					*out++ = ' ';
+					put_number(out, table, px[x]);
+					*out++ = ' ';
+					put_number(out, table, px[x]);
+				}
+				*out++ = rgb || x % gray_values_per_line == gray_values_per_line - 1 ? '\n' : ' ';
+			}
+			// P2 ends the row with a line break instead of the last space
+			if (!rgb && width > 0) out[-1] = '\n';
+			return out;
+		};
+		return write_ascii_rows(file, img.height, width * (rgb ? 12 : 4), format_row);
+	}
+
+#ifdef CIMG_FOUND
+	// Handle PNG and JPG formats using CImg, a single channel is written as grayscale PNG/JPEG
+	try
+	{
+		cimg_library::CImg<unsigned char> cimg(img.width, img.height, 1, 1);
+		// one channel in CImg is stored row by row just like GSImage
+		std::memcpy(cimg.data(), img.pixels.data(), img.pixels.size());
+
+		return save_cimg(dst, cimg, img.exif_data);
 	}
 	catch (const cimg_library::CImgException&)
 	{
@@ -3,10 +3,10 @@
 #include "imgclean/FileHandler.hpp"
 #include "imgclean/ImageFormat.hpp"
 #include "imgclean/PPMImage.hpp"
-#include "imgclean/processors/ImageBinarizationProcessor.hpp"
-#include "imgclean/processors/IntegralImageProcessor.hpp"
-#include <imgclean/processors/HelperProcessor.hpp>
+#include "imgclean/StageRegistry.hpp"
+#include "imgclean/processors/WindowKernel.hpp"
 #include <iostream>
+#include <sstream>
 #include <string>
 
 namespace imgclean
@@ -44,7 +44,57 @@ bool ImgClean::check_format_support(const imgclean::ImageFormat& format, const s
 	return true;
 }
 
-bool ImgClean::clean_image(const std::string& input_path, const std::string& output_path, const std::string& approach)
+bool ImgClean::approach_pipeline(const std::string& approach, const CleanOptions& options, Pipeline& pipeline)
+{
+	const StageDefinition* stage = StageRegistry::find(approach);
+	if (stage == nullptr || stage->input != PixelType::GRAY8 || stage->output != PixelType::BINARY)
+	{
+		std::cerr << "Error: Unknown approach '" << approach << "', expected one of "
+		          << StageRegistry::names(PixelType::GRAY8, PixelType::BINARY) << "\n";
+		return false;
+	}
+	if (!imgclean::processors::is_valid_window_size(options.window_size))
+	{
+		std::cerr << "Error: Window size must be odd and between 1 and "
+		          << imgclean::processors::max_window_size << ", got " << options.window_size << "\n";
+		return false;
+	}
+	if (!(options.threshold > 0.0f))
+	{
+		std::cerr << "Error: Threshold must be positive, got " << options.threshold << "\n";
+		return false;
+	}
+
+	std::ostringstream spec;
+	spec << "gray|" << approach;
+	const char* separator = ":";
+	for (const StageParameter& parameter : stage->parameters)
+	{
+		// "fixed" declares an integer gray level as t, the fraction of the options does not apply
+		const bool is_window   = parameter.name == "w";
+		const bool is_fraction = parameter.name == "t" && parameter.kind == StageParameter::Kind::REAL;
+		const bool is_grid     = parameter.name == "g";
+		if (!is_window && !is_fraction && !is_grid) continue;
+
+		spec << separator << parameter.name << "=";
+		if (is_window) spec << options.window_size;
+		if (is_fraction) spec << options.threshold;
+		if (is_grid) spec << options.grid_factor;
+		separator = ",";
+	}
+	return Pipeline::parse(spec.str(), pipeline, options.fused);
+}
+
+bool ImgClean::clean_image(const std::string& input_path, const std::string& output_path, const std::string& approach,
+                           const CleanOptions& options)
+{
+	Pipeline pipeline;
+	if (!approach_pipeline(approach, options, pipeline)) return false;
+	return clean_image(input_path, output_path, pipeline, options.plain, options.binary);
+}
+
+bool ImgClean::clean_image(const std::string& input_path, const std::string& output_path, const Pipeline& pipeline,
+                           bool plain, bool binary)
 {
 	/////////////////////////////////////////////////////////////////////////
 	///// LOAD INPUT IMAGE
@@ -59,7 +109,8 @@ bool ImgClean::clean_image(const std::string& input_path, const std::string& out
 	if (!imgclean::FileHandler::load_image(input_file, image))
 	{
 		std::cerr << "Error: Failed to load image from '" << input_path << "'\n";
-		std::cerr << "Hint: Ensure the file exists and has a valid file extension (.ppm, .png, .jpg, .jpeg)\n";
+		std::cerr << "Hint: Ensure the file exists and has a valid file extension"
+		          << " (.ppm, .pgm, .pnm, .png, .jpg, .jpeg)\n";
 		return false;
 	}
 
@@ -67,28 +118,20 @@ bool ImgClean::clean_image(const std::string& input_path, const std::string& out
 	///// IMAGE PROCESSING
 	/////////////////////////////////////////////////////////////////////////
 
-	// Convert to grayscale
-	imgclean::GSImage gray_image = imgclean::processors::HelperProcessor::rgb_to_linear_grayscale(image);
-
-	// Apply integral image processor
-	if (approach == "integral")
-	{
-		gray_image = imgclean::processors::IntegralImageProcessor::apply(gray_image);
-	}
-	else if (approach == "adaptive")
+	imgclean::GSImage gray_image;
+	if (!pipeline.run(std::move(image), gray_image))
 	{
-		gray_image = imgclean::processors::ImageBinarizationProcessor::apply(gray_image);
+		std::cerr << "Error: Pipeline '" << pipeline.describe() << "' failed\n";
+		return false;
 	}
 
-	// Convert back to RGB
-	image = imgclean::processors::HelperProcessor::grayscale_to_rgb(gray_image);
-
 	/////////////////////////////////////////////////////////////////////////
 	///// SAVE OUTPUT IMAGE
 	/////////////////////////////////////////////////////////////////////////
 
-	imgclean::FilePath output_file = imgclean::FileHandler::make_file_path(output_path);
-	if (!imgclean::FileHandler::save_image(output_file, image))
+	imgclean::FilePath output_file = imgclean::FileHandler::make_file_path(output_path, plain, binary);
+	// the result is single-channel, save it without expanding it to RGB
+	if (!imgclean::FileHandler::save_image(output_file, gray_image))
 	{
 		std::cerr << "Error: Failed to save image to '" << output_path << "'\n";
 		return false;
@@ -1,4 +1,6 @@
 #include "imgclean/ImgClean.hpp"
+#include "imgclean/StageRegistry.hpp"
+#include <climits>
 #include <cstdlib>
 #include <iostream>
 #include <string>
@@ -7,14 +9,61 @@
 # include <chrono>
 #endif
 
+//! Values accepted by --approach: the registered thresholding stages
+std::string approach_names()
+{
+	return imgclean::StageRegistry::names(imgclean::PixelType::GRAY8, imgclean::PixelType::BINARY);
+}
+
+//! True if name is a registered stage thresholding a gray image
+bool is_known_approach(const std::string& name)
+{
+	const imgclean::StageDefinition* stage = imgclean::StageRegistry::find(name);
+	return stage != nullptr && stage->input == imgclean::PixelType::GRAY8 &&
+	       stage->output == imgclean::PixelType::BINARY;
+}
+
+//! True if the approach stage takes the parameter, "fixed" declares t as an integer gray level
+bool approach_takes(const std::string& approach, const std::string& name, imgclean::StageParameter::Kind kind)
+{
+	const imgclean::StageDefinition* stage = imgclean::StageRegistry::find(approach);
+	if (stage == nullptr) return false;
+	for (const imgclean::StageParameter& parameter : stage->parameters)
+	{
+		if (parameter.name == name && parameter.kind == kind) return true;
+	}
+	return false;
+}
+
 //! Print usage information
 void print_usage(const char* program_name)
 {
-	std::cerr << "Usage: " << program_name << " -i <input> -o <output> [-a <approach>]\n";
+	std::cerr << "Usage: " << program_name << " -i <input> -o <output> [-a <approach>] [-w <size>] [-t <factor>]"
+	          << " [-g <factor>] [-f] [--plain | --binary]\n";
+	std::cerr << "       " << program_name << " -i <input> -o <output> -p <pipeline> [-f] [--plain | --binary]\n";
 	std::cerr << "Options:\n";
 	std::cerr << "  -i, --input <file>      Input image file\n";
 	std::cerr << "  -o, --output <file>     Output image file\n";
-	std::cerr << "  -a, --approach <type>   Cleaning approach: 'integral' or 'adaptive' (default: adaptive)\n";
+	std::cerr << "  -a, --approach <type>   Cleaning approach: " << approach_names() << " (default: adaptive)\n";
+	std::cerr << "  -w, --window <size>     Odd side length of the local window (default: 15)\n";
+	std::cerr << "  -t, --threshold <t>     Fraction of the local mean for 'integral' (default: 0.85)\n";
+	std::cerr << "  -p, --pipeline <spec>   Stages separated by '|', e.g. \"gray|sauvola:w=31,k=0.3\"\n";
+	std::cerr << "  -g, --grid <factor>     Sample the 'integral' or 'adaptive' threshold on every factor-th pixel"
+	          << " and interpolate (default: 1, exact)\n";
+	std::cerr << "  -f, --fused             Stream row strips through gray conversion and thresholding\n";
+	std::cerr << "      --plain             Write .pgm and .pnm output as plain text (P2/P3) instead of binary\n";
+	std::cerr << "      --binary            Write .ppm output as binary (P6) instead of plain text (P3)\n";
+	std::cerr << "Stages:\n";
+	for (const imgclean::StageDefinition& stage : imgclean::StageRegistry::all())
+	{
+		std::string signature = stage.name;
+		for (const imgclean::StageParameter& parameter : stage.parameters)
+		{
+			signature += (&parameter == &stage.parameters.front() ? ":" : ",") + parameter.name;
+		}
+		std::cerr << "  " << signature << std::string(signature.size() < 22 ? 22 - signature.size() : 1, ' ')
+		          << stage.description << "\n";
+	}
 }
 
 int main(int argc, char** argv)
@@ -25,6 +74,11 @@ int main(int argc, char** argv)
 	std::string input_path;
 	std::string output_path;
 	std::string approach = "adaptive";
+	std::string pipeline_spec;
+	bool approach_options = false;
+	bool threshold_set    = false;
+	bool grid_set         = false;
+	imgclean::CleanOptions options;
 
 	// Parse command line arguments
 	for (int i = 1; i < argc; ++i)
@@ -62,20 +116,92 @@ int main(int argc, char** argv)
 			if (i + 1 < argc)
 			{
 				std::string value = argv[++i];
-				if (value == "integral" || value == "adaptive")
+				if (is_known_approach(value))
 				{
-					approach = value;
+					approach         = value;
+					approach_options = true;
 				}
 				else
 				{
-					std::cerr << "Error: --approach must be 'integral' or 'adaptive'\n";
+					std::cerr << "Error: --approach must be one of " << approach_names() << "\n";
 					print_usage(argv[0]);
 					return EXIT_FAILURE;
 				}
 			}
 			else
 			{
-				std::cerr << "Error: --approach requires a value ('integral' or 'adaptive')\n";
+				std::cerr << "Error: --approach requires a value (" << approach_names() << ")\n";
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (arg == "-w" || arg == "--window")
+		{
+			char* end         = nullptr;
+			const long window = i + 1 < argc ? std::strtol(argv[i + 1], &end, 10) : 0;
+			// the range is checked by clean_image
+			if (i + 1 >= argc || *end != '\0' || window < 1 || window > INT_MAX)
+			{
+				std::cerr << "Error: --window requires a positive integer\n";
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			options.window_size = static_cast<int>(window);
+			approach_options    = true;
+			++i;
+		}
+		else if (arg == "-t" || arg == "--threshold")
+		{
+			char* end             = nullptr;
+			const float threshold = i + 1 < argc ? std::strtof(argv[i + 1], &end) : 0.0f;
+			if (i + 1 >= argc || *end != '\0' || !(threshold > 0.0f))
+			{
+				std::cerr << "Error: --threshold requires a positive number\n";
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			options.threshold = threshold;
+			approach_options  = true;
+			threshold_set     = true;
+			++i;
+		}
+		else if (arg == "-g" || arg == "--grid")
+		{
+			char* end         = nullptr;
+			const long factor = i + 1 < argc ? std::strtol(argv[i + 1], &end, 10) : 0;
+			// the range is checked by the pipeline
+			if (i + 1 >= argc || *end != '\0' || factor < 1 || factor > INT_MAX)
+			{
+				std::cerr << "Error: --grid requires a positive integer\n";
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			options.grid_factor = static_cast<int>(factor);
+			approach_options    = true;
+			grid_set            = true;
+			++i;
+		}
+		else if (arg == "-f" || arg == "--fused")
+		{
+			options.fused = true;
+		}
+		else if (arg == "--plain")
+		{
+			options.plain = true;
+		}
+		else if (arg == "--binary")
+		{
+			options.binary = true;
+		}
+		else if (arg == "-p" || arg == "--pipeline")
+		{
+			if (i + 1 < argc)
+			{
+				pipeline_spec = argv[++i];
+			}
+			else
+			{
+				std::cerr << "Error: --pipeline requires a list of stages\n";
 				print_usage(argv[0]);
 				return EXIT_FAILURE;
 			}
@@ -95,6 +221,45 @@ int main(int argc, char** argv)
 		return EXIT_FAILURE;
 	}
 
+	if (!pipeline_spec.empty() && approach_options)
+	{
+		std::cerr << "Error: --pipeline sets all stages and their parameters, it cannot be combined with "
+		             "--approach, --window, --threshold or --grid\n";
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (options.plain && options.binary)
+	{
+		std::cerr << "Error: --plain and --binary select opposite netpbm variants\n";
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// options the approach has no parameter for would be dropped silently
+	using Kind = imgclean::StageParameter::Kind;
+	if (pipeline_spec.empty() && threshold_set && !approach_takes(approach, "t", Kind::REAL))
+	{
+		std::cerr << "Error: --threshold does not apply to approach '" << approach << "'\n";
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (pipeline_spec.empty() && grid_set && !approach_takes(approach, "g", Kind::INTEGER))
+	{
+		std::cerr << "Error: --grid does not apply to approach '" << approach << "'\n";
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	imgclean::Pipeline pipeline;
+	const bool valid = pipeline_spec.empty() ? imgclean::ImgClean::approach_pipeline(approach, options, pipeline)
+	                                         : imgclean::Pipeline::parse(pipeline_spec, pipeline, options.fused);
+	if (!valid)
+	{
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
 /////////////////////////////////////////////////////////////////////////
 ///// IMAGE PROCESSING
 /////////////////////////////////////////////////////////////////////////
@@ -102,7 +267,7 @@ int main(int argc, char** argv)
 	auto start_time = std::chrono::high_resolution_clock::now();
 #endif
 
-	bool success = imgclean::ImgClean::clean_image(input_path, output_path, approach);
+	bool success = imgclean::ImgClean::clean_image(input_path, output_path, pipeline, options.plain, options.binary);
 	if (!success)
 	{
 		std::cerr << "Error: Image cleaning failed\n";
@@ -0,0 +1,303 @@
+#include "imgclean/Pipeline.hpp"
+
+#include "imgclean/StageRegistry.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/WindowKernel.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+namespace imgclean
+{
+namespace
+{
+//! Splits text at every separator, keeps empty parts
+std::vector<std::string> split(const std::string& text, char separator)
+{
+	std::vector<std::string> parts;
+	size_t begin = 0;
+	while (true)
+	{
+		const size_t end = text.find(separator, begin);
+		parts.push_back(text.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+		if (end == std::string::npos) break;
+		begin = end + 1;
+	}
+	return parts;
+}
+
+//! Removes leading and trailing spaces
+std::string trim(const std::string& text)
+{
+	const size_t begin = text.find_first_not_of(" \t");
+	if (begin == std::string::npos) return std::string();
+	const size_t end = text.find_last_not_of(" \t");
+	return text.substr(begin, end - begin + 1);
+}
+
+//! Checks a parameter value against its declaration, prints the reason if it is invalid
+bool check_value(const std::string& stage, const StageParameter& parameter, double value)
+{
+	const bool integral = value == std::floor(value);
+	bool valid          = value >= parameter.min_value && value <= parameter.max_value;
+	if (parameter.kind == StageParameter::Kind::INTEGER) valid = valid && integral;
+	if (parameter.kind == StageParameter::Kind::WINDOW)
+	{
+		valid = valid && integral && processors::is_valid_window_size(static_cast<int>(value));
+	}
+	if (valid) return true;
+
+	std::cerr << "Error: Invalid value " << value << " for parameter '" << parameter.name << "' of stage '" << stage
+	          << "', expected ";
+	if (parameter.kind == StageParameter::Kind::WINDOW) std::cerr << "an odd integer ";
+	if (parameter.kind == StageParameter::Kind::INTEGER) std::cerr << "an integer ";
+	std::cerr << "between " << parameter.min_value << " and " << parameter.max_value << "\n";
+	return false;
+}
+
+//! Configured stage of a definition
+Pipeline::Stage make_stage(const StageDefinition& definition, const ParameterValues& values)
+{
+	Pipeline::Stage stage;
+	stage.name   = definition.name;
+	stage.values = values;
+	stage.input  = definition.input;
+	stage.output = definition.output;
+	stage.run    = definition.make(values);
+	return stage;
+}
+
+//! Stage of a definition with all parameters at their defaults
+Pipeline::Stage make_default_stage(const std::string& name)
+{
+	const StageDefinition& definition = *StageRegistry::find(name);
+	ParameterValues values;
+	for (const StageParameter& parameter : definition.parameters)
+	{
+		values[parameter.name] = parameter.default_value;
+	}
+	return make_stage(definition, values);
+}
+
+//! Parses one "name:args" entry of a pipeline, prints the reason and returns false if it is invalid
+bool parse_stage(const std::string& text, Pipeline::Stage& stage)
+{
+	const size_t colon = text.find(':');
+	std::string name   = trim(text.substr(0, colon));
+	std::vector<std::string> arguments;
+	if (colon != std::string::npos) arguments = split(text.substr(colon + 1), ',');
+
+	const StageDefinition* definition = StageRegistry::find(name);
+	if (definition == nullptr)
+	{
+		// "median3" -> "median:3"
+		const size_t digits = name.find_last_not_of("0123456789") + 1;
+		if (digits > 0 && digits < name.size())
+		{
+			definition = StageRegistry::find(name.substr(0, digits));
+			if (definition != nullptr) arguments.insert(arguments.begin(), name.substr(digits));
+		}
+	}
+	if (definition == nullptr)
+	{
+		std::cerr << "Error: Unknown stage '" << name << "', available stages:";
+		for (const StageDefinition& available : StageRegistry::all())
+		{
+			std::cerr << " " << available.name;
+		}
+		std::cerr << "\n";
+		return false;
+	}
+
+	ParameterValues values;
+	for (const StageParameter& parameter : definition->parameters)
+	{
+		values[parameter.name] = parameter.default_value;
+	}
+
+	size_t positional = 0;
+	for (const std::string& raw : arguments)
+	{
+		const std::string argument = trim(raw);
+		const size_t equals        = argument.find('=');
+		std::string key;
+		std::string value_text;
+		if (equals == std::string::npos)
+		{
+			if (positional >= definition->parameters.size())
+			{
+				std::cerr << "Error: Too many arguments for stage '" << definition->name << "'\n";
+				return false;
+			}
+			key        = definition->parameters[positional++].name;
+			value_text = argument;
+		}
+		else
+		{
+			key        = trim(argument.substr(0, equals));
+			value_text = trim(argument.substr(equals + 1));
+		}
+
+		const StageParameter* parameter = nullptr;
+		for (const StageParameter& candidate : definition->parameters)
+		{
+			if (candidate.name == key) parameter = &candidate;
+		}
+		if (parameter == nullptr)
+		{
+			std::cerr << "Error: Stage '" << definition->name << "' has no parameter '" << key << "'\n";
+			return false;
+		}
+
+		char* end          = nullptr;
+		const double value = std::strtod(value_text.c_str(), &end);
+		if (value_text.empty() || *end != '\0')
+		{
+			std::cerr << "Error: '" << value_text << "' is not a number (parameter '" << key
+			          << "' of stage '" << definition->name << "')\n";
+			return false;
+		}
+		if (!check_value(definition->name, *parameter, value)) return false;
+		values[key] = value;
+	}
+
+	stage = make_stage(*definition, values);
+	return true;
+}
+} // namespace
+
+const char* to_string(PixelType type)
+{
+	switch (type)
+	{
+	case PixelType::RGB16: return "RGB16";
+	case PixelType::GRAY8: return "GRAY8";
+	case PixelType::BINARY: return "BINARY";
+	}
+	return "UNKNOWN";
+}
+
+void ImageBuffer::release(PixelType type)
+{
+	switch (type)
+	{
+	case PixelType::RGB16: rgb = PPMImage(); break;
+	case PixelType::GRAY8: gray = GSImage(); break;
+	case PixelType::BINARY: binary = BinaryImage(); break;
+	}
+}
+
+bool Pipeline::parse(const std::string& spec, Pipeline& pipeline, bool fuse)
+{
+	Pipeline result;
+	for (const std::string& entry : split(spec, '|'))
+	{
+		if (trim(entry).empty())
+		{
+			std::cerr << "Error: Empty stage in pipeline '" << spec << "'\n";
+			return false;
+		}
+
+		Stage stage;
+		if (!parse_stage(entry, stage) || !result.push(std::move(stage), fuse)) return false;
+	}
+
+	if (result.stage_list.back().output == PixelType::RGB16)
+	{
+		std::cerr << "Error: Pipeline '" << spec << "' does not produce a gray or binary image\n";
+		return false;
+	}
+
+	pipeline = std::move(result);
+	return true;
+}
+
+bool Pipeline::push(Stage stage, bool fuse)
+{
+	const PixelType current = stage_list.empty() ? PixelType::RGB16 : stage_list.back().output;
+	if (stage.input != current)
+	{
+		// lossless or canonical conversions to gray are inserted, anything else needs an explicit stage
+		if (stage.input == PixelType::GRAY8 && current == PixelType::RGB16)
+		{
+			if (!push(make_default_stage("gray"), fuse)) return false;
+		}
+		else if (stage.input == PixelType::GRAY8 && current == PixelType::BINARY)
+		{
+			if (!push(make_default_stage("expand"), fuse)) return false;
+		}
+		else
+		{
+			std::cerr << "Error: Stage '" << stage.name << "' reads " << to_string(stage.input)
+			          << " pixels but receives " << to_string(current) << "\n";
+			return false;
+		}
+	}
+
+	stage.input_slot  = stage_list.empty() ? 0 : stage_list.back().output_slot;
+	stage.output_slot = stage.output == stage.input ? 1 - stage.input_slot : stage.input_slot;
+
+	const StageDefinition& definition = *StageRegistry::find(stage.name);
+	if (fuse && definition.make_fused && !stage_list.empty() && stage_list.back().name == "gray")
+	{
+		stage_list.back().fused = true;
+		stage.run               = definition.make_fused(stage.values);
+	}
+
+	stage_list.push_back(std::move(stage));
+	return true;
+}
+
+bool Pipeline::run(PPMImage input, GSImage& output) const
+{
+	if (stage_list.empty() || input.empty()) return false;
+
+	slots.resize(2);
+	slots[stage_list.front().input_slot].rgb = std::move(input);
+
+	// first stage of the current step, a fused stage runs as part of the following one
+	const Stage* head = &stage_list.front();
+	for (const Stage& stage : stage_list)
+	{
+		if (stage.fused) continue;
+		stage.run(slots[head->input_slot], slots[stage.output_slot]);
+		slots[head->input_slot].release(head->input);
+		head = &stage + 1;
+	}
+
+	ImageBuffer& result = slots[stage_list.back().output_slot];
+	if (stage_list.back().output == PixelType::BINARY)
+	{
+		output = processors::HelperProcessor::binary_to_grayscale(result.binary);
+		result.release(PixelType::BINARY);
+	}
+	else
+	{
+		output = std::move(result.gray);
+		result.release(PixelType::GRAY8);
+	}
+
+	return !output.empty();
+}
+
+std::string Pipeline::describe() const
+{
+	std::ostringstream text;
+	for (const Stage& stage : stage_list)
+	{
+		if (&stage != &stage_list.front()) text << "|";
+		text << stage.name;
+
+		// declared order, the map is sorted by name
+		const char* separator = ":";
+		for (const StageParameter& parameter : StageRegistry::find(stage.name)->parameters)
+		{
+			text << separator << parameter.name << "=" << stage.values.at(parameter.name);
+			separator = ",";
+		}
+	}
+	return text.str();
+}
+
+} // namespace imgclean
@@ -0,0 +1,286 @@
+#include "imgclean/StageRegistry.hpp"
+
+#include "imgclean/processors/BackgroundProcessor.hpp"
+#include "imgclean/processors/ClaheProcessor.hpp"
+#include "imgclean/processors/DespeckleProcessor.hpp"
+#include "imgclean/processors/GaussianProcessor.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/ImageBinarizationProcessor.hpp"
+#include "imgclean/processors/IntegralImageProcessor.hpp"
+#include "imgclean/processors/MedianProcessor.hpp"
+#include "imgclean/processors/NiblackProcessor.hpp"
+#include "imgclean/processors/OtsuProcessor.hpp"
+#include "imgclean/processors/SauvolaProcessor.hpp"
+#include "imgclean/processors/ThresholdSurface.hpp"
+#include "imgclean/processors/WindowKernel.hpp"
+#include "imgclean/processors/WolfProcessor.hpp"
+
+namespace imgclean
+{
+namespace
+{
+using processors::WindowEngine;
+
+//! Both engines give identical results, the rolling sums are the faster one
+constexpr WindowEngine engine = WindowEngine::SLIDING_WINDOW;
+
+StageParameter window_parameter(int default_value)
+{
+	return {"w", StageParameter::Kind::WINDOW, static_cast<double>(default_value), 1.0,
+	        static_cast<double>(processors::max_window_size)};
+}
+
+StageParameter real_parameter(const std::string& name, float default_value, double min_value, double max_value)
+{
+	return {name, StageParameter::Kind::REAL, static_cast<double>(default_value), min_value, max_value};
+}
+
+int window_value(const ParameterValues& values) { return static_cast<int>(values.at("w")); }
+int grid_value(const ParameterValues& values) { return static_cast<int>(values.at("g")); }
+float real_value(const ParameterValues& values, const std::string& name)
+{
+	return static_cast<float>(values.at(name));
+}
+
+StageFunction make_gray(const ParameterValues&)
+{
+	return [](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.gray = processors::HelperProcessor::rgb_to_linear_grayscale(in.rgb);
+	};
+}
+
+StageFunction make_expand(const ParameterValues&)
+{
+	return [](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.gray = processors::HelperProcessor::binary_to_grayscale(in.binary);
+	};
+}
+
+StageFunction make_background(const ParameterValues& values)
+{
+	const int window = window_value(values);
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.gray = processors::BackgroundProcessor::apply(in.gray, window);
+	};
+}
+
+StageFunction make_clahe(const ParameterValues& values)
+{
+	const int tiles  = static_cast<int>(values.at("n"));
+	const float clip = real_value(values, "c");
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.gray = processors::ClaheProcessor::apply(in.gray, tiles, clip);
+	};
+}
+
+StageFunction make_gaussian(const ParameterValues& values)
+{
+	const float sigma = real_value(values, "s");
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.gray = processors::GaussianProcessor::apply(in.gray, sigma);
+	};
+}
+
+StageFunction make_median(const ParameterValues& values)
+{
+	const int window = window_value(values);
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.gray = processors::MedianProcessor::apply(in.gray, window);
+	};
+}
+
+StageFunction make_fixed(const ParameterValues& values)
+{
+	const uint8_t threshold = static_cast<uint8_t>(values.at("t"));
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.binary = processors::HelperProcessor::grayscale_to_binary(in.gray, threshold);
+	};
+}
+
+StageFunction make_integral(const ParameterValues& values)
+{
+	const int window = window_value(values);
+	const float t    = real_value(values, "t");
+	const int grid   = grid_value(values);
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.binary = processors::IntegralImageProcessor::apply_approximate(in.gray, engine, window, t, grid);
+	};
+}
+
+StageFunction make_fused_integral(const ParameterValues& values)
+{
+	const int window = window_value(values);
+	const float t    = real_value(values, "t");
+	const int grid   = grid_value(values);
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		using processors::IntegralImageProcessor;
+		if (grid == 1)
+		{
+			out.binary = IntegralImageProcessor::apply_rgb(in.rgb, window, t);
+			return;
+		}
+		// the threshold surface is not fused, convert first
+		const GSImage gray = processors::HelperProcessor::rgb_to_linear_grayscale(in.rgb);
+		out.binary         = IntegralImageProcessor::apply_approximate(gray, engine, window, t, grid);
+	};
+}
+
+//! The threshold surface needs the whole page, only g = 1 is streamed, otherwise the stream is empty
+processors::ThresholdStream make_stream_integral(int width, const ParameterValues& values)
+{
+	if (grid_value(values) != 1) return processors::ThresholdStream();
+	return processors::IntegralImageProcessor::stream(width, window_value(values), real_value(values, "t"));
+}
+
+StageFunction make_adaptive(const ParameterValues& values)
+{
+	const int window = window_value(values);
+	const int grid   = grid_value(values);
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.binary = processors::ImageBinarizationProcessor::apply_approximate(in.gray, engine, window, grid);
+	};
+}
+
+//! Stage of a processor with apply_binary(image, engine, window, k)
+template <typename Processor>
+StageFunction make_local_threshold(const ParameterValues& values)
+{
+	const int window = window_value(values);
+	const float k    = real_value(values, "k");
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.binary = Processor::apply_binary(in.gray, engine, window, k);
+	};
+}
+
+//! Fused stage of a processor with apply_rgb(image, window, k)
+template <typename Processor>
+StageFunction make_fused_local_threshold(const ParameterValues& values)
+{
+	const int window = window_value(values);
+	const float k    = real_value(values, "k");
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.binary = Processor::apply_rgb(in.rgb, window, k);
+	};
+}
+
+//! Row stream of a processor with stream(width, window, k)
+template <typename Processor>
+processors::ThresholdStream make_stream_local_threshold(int width, const ParameterValues& values)
+{
+	return Processor::stream(width, window_value(values), real_value(values, "k"));
+}
+
+StageFunction make_otsu(const ParameterValues&)
+{
+	return [](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.binary = processors::OtsuProcessor::apply_binary(in.gray);
+	};
+}
+
+StageFunction make_despeckle(const ParameterValues& values)
+{
+	const int min_area = static_cast<int>(values.at("a"));
+	return [=](const ImageBuffer& in, ImageBuffer& out)
+	{
+		out.binary = processors::DespeckleProcessor::apply(in.binary, min_area);
+	};
+}
+
+std::vector<StageDefinition> builtin_stages()
+{
+	using namespace processors;
+	constexpr PixelType rgb    = PixelType::RGB16;
+	constexpr PixelType gray   = PixelType::GRAY8;
+	constexpr PixelType binary = PixelType::BINARY;
+
+	// all windowed processors default to the same window size
+	const StageParameter w         = window_parameter(IntegralImageProcessor::default_window_size);
+	const StageParameter closing_w = window_parameter(BackgroundProcessor::default_window_size);
+	const StageParameter median_w  = {"w", StageParameter::Kind::WINDOW, MedianProcessor::default_window_size, 1.0,
+	                                  MedianProcessor::max_window_size};
+	const StageParameter tiles     = {"n", StageParameter::Kind::INTEGER, ClaheProcessor::default_tiles, 1.0,
+	                                  ClaheProcessor::max_tiles};
+	const StageParameter clip      = real_parameter("c", ClaheProcessor::default_clip_limit, 1.0, 256.0);
+	const StageParameter sigma     = real_parameter("s", GaussianProcessor::default_sigma, 0.1, 100.0);
+	const StageParameter t         = real_parameter("t", IntegralImageProcessor::default_t, 1e-3, 10.0);
+	const StageParameter fixed_t   = {"t", StageParameter::Kind::INTEGER, 128.0, 0.0, 255.0};
+	const StageParameter niblack_k = real_parameter("k", NiblackProcessor::default_k, -10.0, 10.0);
+	const StageParameter sauvola_k = real_parameter("k", SauvolaProcessor::default_k, -10.0, 10.0);
+	const StageParameter wolf_k    = real_parameter("k", WolfProcessor::default_k, -10.0, 10.0);
+	// smallest ink component kept by despeckle, in pixels
+	const StageParameter min_area = {"a", StageParameter::Kind::INTEGER,
+	                                 static_cast<double>(DespeckleProcessor::default_min_area), 1.0, 1 << 20};
+	// grid factor of the approximate threshold surface, 1 is exact
+	const StageParameter g = {"g", StageParameter::Kind::INTEGER, 1.0, 1.0, ThresholdSurface::max_factor};
+
+	return {
+		{"gray", "linear grayscale of the RGB input, rescaled to 0-255", rgb, gray, {}, make_gray},
+		{"expand", "bit-packed image to gray, ink 0 and background 255", binary, gray, {}, make_expand},
+		{"background", "divides by the background, a closing over a large window", gray, gray, {closing_w},
+		 make_background},
+		{"clahe", "local contrast equalization on n x n tiles, histograms clipped at c", gray, gray,
+		 {tiles, clip}, make_clahe},
+		{"gaussian", "Gaussian smoothing with sigma s, three stacked box filters", gray, gray, {sigma},
+		 make_gaussian},
+		{"median", "median of the w x w window, removes noise", gray, gray, {median_w}, make_median},
+		{"fixed", "global threshold t, darker pixels become ink", gray, binary, {fixed_t}, make_fixed},
+		{"integral", "pixels darker than t times the local mean become ink", gray, binary, {w, t, g},
+		 make_integral, make_fused_integral, make_stream_integral},
+		{"adaptive", "threshold from local mean and contrast, normalized over the page", gray, binary, {w, g},
+		 make_adaptive},
+		{"niblack", "Niblack, T = m + k * s", gray, binary, {w, niblack_k},
+		 make_local_threshold<NiblackProcessor>, make_fused_local_threshold<NiblackProcessor>,
+		 make_stream_local_threshold<NiblackProcessor>},
+		{"sauvola", "Sauvola, T = m * (1 + k * (s / R - 1))", gray, binary, {w, sauvola_k},
+		 make_local_threshold<SauvolaProcessor>, make_fused_local_threshold<SauvolaProcessor>,
+		 make_stream_local_threshold<SauvolaProcessor>},
+		{"wolf", "Wolf-Jolion, Sauvola normalized by the page", gray, binary, {w, wolf_k},
+		 make_local_threshold<WolfProcessor>},
+		{"otsu", "global Otsu threshold", gray, binary, {}, make_otsu},
+		{"despeckle", "removes ink components of less than a pixels", binary, binary, {min_area},
+		 make_despeckle},
+	};
+}
+} // namespace
+
+const std::vector<StageDefinition>& StageRegistry::all()
+{
+	static const std::vector<StageDefinition> stages = builtin_stages();
+	return stages;
+}
+
+const StageDefinition* StageRegistry::find(const std::string& name)
+{
+	for (const StageDefinition& definition : all())
+	{
+		if (definition.name == name) return &definition;
+	}
+	return nullptr;
+}
+
+std::string StageRegistry::names(PixelType input, PixelType output)
+{
+	std::string result;
+	for (const StageDefinition& definition : all())
+	{
+		if (definition.input != input || definition.output != output) continue;
+		if (!result.empty()) result += ", ";
+		result += definition.name;
+	}
+	return result;
+}
+
+} // namespace imgclean
@@ -0,0 +1,76 @@
+#include "imgclean/StreamCleaner.hpp"
+
+#include "imgclean/StageRegistry.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include <iostream>
+#include <utility>
+
+namespace imgclean
+{
+
+bool StreamCleaner::create(const Pipeline& pipeline, int width, RowSink sink, StreamCleaner& cleaner)
+{
+	if (width <= 0)
+	{
+		std::cerr << "Error: Stream width must be positive, got " << width << "\n";
+		return false;
+	}
+
+	// the RGB rows are converted on the fly, only the thresholding stage itself is streamed
+	const std::vector<Pipeline::Stage>& stages = pipeline.stages();
+	const bool gray_first                      = !stages.empty() && stages.front().name == "gray";
+
+	const StageDefinition* definition = stages.empty() ? nullptr : StageRegistry::find(stages.back().name);
+	if (stages.size() != (gray_first ? 2u : 1u) || definition == nullptr || !definition->make_stream)
+	{
+		std::cerr << "Error: Pipeline '" << pipeline.describe() << "' cannot be streamed, expected one of the stages";
+		for (const StageDefinition& available : StageRegistry::all())
+		{
+			if (available.make_stream) std::cerr << " " << available.name;
+		}
+		std::cerr << "\n";
+		return false;
+	}
+
+	cleaner.stream = definition->make_stream(width, stages.back().values);
+	if (cleaner.stream.empty())
+	{
+		std::cerr << "Error: Pipeline '" << pipeline.describe() << "' cannot be streamed with these parameters,"
+		          << " the grid approximation g needs the whole page\n";
+		return false;
+	}
+	cleaner.sink = std::move(sink);
+	cleaner.gray_row.resize(width);
+	return true;
+}
+
+bool StreamCleaner::create(const std::string& approach, const CleanOptions& options, int width, RowSink sink,
+                           StreamCleaner& cleaner)
+{
+	Pipeline pipeline;
+	if (!ImgClean::approach_pipeline(approach, options, pipeline)) return false;
+	return create(pipeline, width, std::move(sink), cleaner);
+}
+
+void StreamCleaner::push_rows(const uint16_t* rgb, int count, uint16_t max_luma)
+{
+	const size_t row_samples = static_cast<size_t>(width()) * 3;
+	for (int r = 0; r < count; ++r)
+	{
+		processors::HelperProcessor::linear_grayscale_row(rgb + r * row_samples, width(), max_luma, gray_row.data());
+		stream.push_row(gray_row.data(), sink);
+	}
+}
+
+void StreamCleaner::push_rows(const uint8_t* gray, int count)
+{
+	const size_t row_pixels = static_cast<size_t>(width());
+	for (int r = 0; r < count; ++r)
+	{
+		stream.push_row(gray + r * row_pixels, sink);
+	}
+}
+
+void StreamCleaner::finish() { stream.finish(sink); }
+
+} // namespace imgclean
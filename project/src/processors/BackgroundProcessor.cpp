@@ -0,0 +1,229 @@
+#include "imgclean/processors/BackgroundProcessor.hpp"
+#include "imgclean/processors/WindowKernel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace imgclean::processors
+{
+namespace
+{
+struct MaxOp
+{
+	static constexpr uint8_t identity = 0;
+	static uint8_t apply(uint8_t a, uint8_t b) { return std::max(a, b); }
+};
+
+struct MinOp
+{
+	static constexpr uint8_t identity = 255;
+	static uint8_t apply(uint8_t a, uint8_t b) { return std::min(a, b); }
+};
+
+//! Length of the padded line: radius identity elements on both sides, rounded up to whole blocks
+int padded_length(int n, int window_size)
+{
+	return (n + window_size - 1 + window_size - 1) / window_size * window_size;
+}
+
+//! van Herk/Gil-Werman filter of one contiguous line of n values.
+//! The line is padded with radius identity values on both sides and cut into blocks of window_size:
+//! g holds the running result from the start of each block, h the one towards the end of each block.
+//! The window starting at padded index x spans at most two blocks, its result is Op(h[x], g[x + w - 1]).
+//! padded, g and h hold padded_length(n) values.
+template <typename Op>
+void filter_line(const uint8_t* src, uint8_t* dst, int n, int window_size, uint8_t* padded, uint8_t* g,
+                 uint8_t* h)
+{
+	const int radius = window_size / 2;
+	const int length = padded_length(n, window_size);
+	std::fill(padded, padded + radius, Op::identity);
+	std::copy(src, src + n, padded + radius);
+	std::fill(padded + radius + n, padded + length, Op::identity);
+
+	for (int block = 0; block < length; block += window_size)
+	{
+		const int last = block + window_size - 1;
+		g[block]       = padded[block];
+		for (int i = block + 1; i <= last; ++i)
+		{
+			g[i] = Op::apply(g[i - 1], padded[i]);
+		}
+		h[last] = padded[last];
+		for (int i = last - 1; i >= block; --i)
+		{
+			h[i] = Op::apply(h[i + 1], padded[i]);
+		}
+	}
+
+	for (int x = 0; x < n; ++x)
+	{
+		dst[x] = Op::apply(h[x], g[x + window_size - 1]);
+	}
+}
+
+//! filter_line along the columns [x_begin, x_end) of the image, all columns of the strip side by side.
+//! g and h hold padded_length(height) rows of the strip width.
+template <typename Op>
+void filter_columns(const uint8_t* src, uint8_t* dst, int width, int height, int x_begin, int x_end,
+                    int window_size, uint8_t* g, uint8_t* h)
+{
+	const int radius = window_size / 2;
+	const int length = padded_length(height, window_size);
+	const int lanes  = x_end - x_begin;
+
+	//! Row i of the padded strip, nullptr for the identity rows
+	auto padded_row = [&](int i)
+	{
+		if (i < radius || i >= radius + height) return static_cast<const uint8_t*>(nullptr);
+		return src + static_cast<size_t>(i - radius) * width + x_begin;
+	};
+	auto strip_row = [&](uint8_t* strip, int i) { return strip + static_cast<size_t>(i) * lanes; };
+	//! out = Op(prev, row i), or row i alone if prev is nullptr
+	auto combine = [&](uint8_t* out, const uint8_t* prev, int i)
+	{
+		const uint8_t* in = padded_row(i);
+		if (in == nullptr)
+		{
+			// Op(prev, identity) = prev
+			if (prev) std::copy(prev, prev + lanes, out);
+			else std::fill(out, out + lanes, Op::identity);
+		}
+		else if (prev == nullptr)
+		{
+			std::copy(in, in + lanes, out);
+		}
+		else
+		{
+			for (int x = 0; x < lanes; ++x)
+			{
+				out[x] = Op::apply(prev[x], in[x]);
+			}
+		}
+	};
+
+	for (int block = 0; block < length; block += window_size)
+	{
+		combine(strip_row(g, block), nullptr, block);
+		for (int i = block + 1; i < block + window_size; ++i)
+		{
+			combine(strip_row(g, i), strip_row(g, i - 1), i);
+		}
+		combine(strip_row(h, block + window_size - 1), nullptr, block + window_size - 1);
+		for (int i = block + window_size - 2; i >= block; --i)
+		{
+			combine(strip_row(h, i), strip_row(h, i + 1), i);
+		}
+	}
+
+	for (int y = 0; y < height; ++y)
+	{
+		const uint8_t* top    = strip_row(h, y);
+		const uint8_t* bottom = strip_row(g, y + window_size - 1);
+		uint8_t* out          = dst + static_cast<size_t>(y) * width + x_begin;
+		for (int x = 0; x < lanes; ++x)
+		{
+			out[x] = Op::apply(top[x], bottom[x]);
+		}
+	}
+}
+
+//! Separable square filter: rows first, then columns in strips
+template <typename Op>
+GSImage filter(const GSImage& image, int window_size, int strip_columns)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return GSImage();
+
+	const int width  = image.width;
+	const int height = image.height;
+
+	// horizontal pass into rows, vertical pass from rows into the output
+	std::vector<uint8_t> rows(image.pixel_count());
+#pragma omp parallel
+	{
+		std::vector<uint8_t> padded(padded_length(width, window_size));
+		std::vector<uint8_t> g(padded.size());
+		std::vector<uint8_t> h(padded.size());
+#pragma omp for schedule(static)
+		for (int y = 0; y < height; ++y)
+		{
+			const size_t offset = static_cast<size_t>(y) * width;
+			const uint8_t* in   = image.pixels.data() + offset;
+			filter_line<Op>(in, rows.data() + offset, width, window_size, padded.data(), g.data(),
+			                h.data());
+		}
+	}
+
+	GSImage output_image;
+	output_image.width     = width;
+	output_image.height    = height;
+	output_image.maxval    = image.maxval;
+	output_image.exif_data = image.exif_data;
+	output_image.pixels.resize(image.pixel_count());
+
+	const int num_strips = (width + strip_columns - 1) / strip_columns;
+	uint8_t* out         = output_image.pixels.data();
+#pragma omp parallel
+	{
+		const size_t strip_size = static_cast<size_t>(padded_length(height, window_size)) * strip_columns;
+		std::vector<uint8_t> g(strip_size);
+		std::vector<uint8_t> h(strip_size);
+#pragma omp for schedule(static)
+		for (int s = 0; s < num_strips; ++s)
+		{
+			const int x_begin = s * strip_columns;
+			const int x_end   = std::min(width, x_begin + strip_columns);
+			filter_columns<Op>(rows.data(), out, width, height, x_begin, x_end, window_size, g.data(),
+			                   h.data());
+		}
+	}
+
+	return output_image;
+}
+} // namespace
+
+GSImage BackgroundProcessor::max_filter(const GSImage& image, int window_size)
+{
+	return filter<MaxOp>(image, window_size, strip_columns);
+}
+
+GSImage BackgroundProcessor::min_filter(const GSImage& image, int window_size)
+{
+	return filter<MinOp>(image, window_size, strip_columns);
+}
+
+GSImage BackgroundProcessor::estimate(const GSImage& image, int window_size)
+{
+	return min_filter(max_filter(image, window_size), window_size);
+}
+
+GSImage BackgroundProcessor::apply(const GSImage& image, int window_size)
+{
+	GSImage output_image = estimate(image, window_size);
+	if (output_image.empty()) return output_image;
+
+	// the closing never lies below the image, so pixel / background <= 1
+	std::array<float, 256> scale;
+	scale[0] = 0.0f;
+	for (int background = 1; background < 256; ++background)
+	{
+		scale[background] = 255.0f / static_cast<float>(background);
+	}
+
+	const size_t num_pixels = image.pixel_count();
+	const uint8_t* pixels   = image.pixels.data();
+	uint8_t* out            = output_image.pixels.data();
+#pragma omp parallel for schedule(static)
+	for (size_t i = 0; i < num_pixels; ++i)
+	{
+		// a background of 0 only occurs under black pixels, which are background there
+		const float value = out[i] == 0 ? 255.0f : static_cast<float>(pixels[i]) * scale[out[i]] + 0.5f;
+		out[i]            = static_cast<uint8_t>(std::min(value, 255.0f));
+	}
+	output_image.maxval = 255;
+
+	return output_image;
+}
+
+} // namespace imgclean::processors
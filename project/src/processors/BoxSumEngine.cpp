@@ -0,0 +1,64 @@
+#include "imgclean/processors/BoxSumEngine.hpp"
+
+namespace imgclean::processors
+{
+
+BoxSumEngine::BoxSumEngine(int width, int half_window, bool squares)
+	: width(width)
+	, half_window(half_window)
+	, squares(squares)
+	, col_sum(width, 0)
+	, col_sum_sq(squares ? width : 0, 0)
+{
+}
+
+void BoxSumEngine::reset()
+{
+	std::fill(col_sum.begin(), col_sum.end(), 0);
+	std::fill(col_sum_sq.begin(), col_sum_sq.end(), 0);
+	band_rows = 0;
+}
+
+void BoxSumEngine::add_row(const uint8_t* row)
+{
+	uint32_t* sum = col_sum.data();
+#pragma omp simd
+	for (int x = 0; x < width; ++x)
+	{
+		sum[x] += row[x];
+	}
+
+	if (squares)
+	{
+		uint32_t* sum_sq = col_sum_sq.data();
+#pragma omp simd
+		for (int x = 0; x < width; ++x)
+		{
+			sum_sq[x] += static_cast<uint32_t>(row[x]) * row[x];
+		}
+	}
+	++band_rows;
+}
+
+void BoxSumEngine::remove_row(const uint8_t* row)
+{
+	uint32_t* sum = col_sum.data();
+#pragma omp simd
+	for (int x = 0; x < width; ++x)
+	{
+		sum[x] -= row[x];
+	}
+
+	if (squares)
+	{
+		uint32_t* sum_sq = col_sum_sq.data();
+#pragma omp simd
+		for (int x = 0; x < width; ++x)
+		{
+			sum_sq[x] -= static_cast<uint32_t>(row[x]) * row[x];
+		}
+	}
+	--band_rows;
+}
+
+} // namespace imgclean::processors
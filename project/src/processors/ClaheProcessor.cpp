@@ -0,0 +1,216 @@
+#include "imgclean/processors/ClaheProcessor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+#endif
+
+namespace imgclean::processors
+{
+namespace
+{
+//! Fraction bits of the interpolation weights
+constexpr int weight_bits = 8;
+
+//! Tile grid along one axis: the tiles, their size, and for every pixel the two nearest tile centers
+//! (t0 <= t1) with the fixed-point weight of t1. offset0 and offset1 are t0 * 256 and t1 * 256.
+struct TileAxis
+{
+	int tiles     = 1;
+	int tile_size = 1;
+	std::vector<int> t0;
+	std::vector<int> t1;
+	std::vector<uint32_t> weight;
+	std::vector<int> offset0;
+	std::vector<int> offset1;
+
+	TileAxis(int size, int requested_tiles)
+		: tiles(std::min(requested_tiles, size))
+		, tile_size((size + tiles - 1) / tiles)
+		, t0(size)
+		, t1(size)
+		, weight(size)
+		, offset0(size)
+		, offset1(size)
+	{
+		// the last tile may be cut short, keep the tile count in line with the rounded-up size
+		tiles            = (size + tile_size - 1) / tile_size;
+		const float unit = static_cast<float>(1 << weight_bits);
+		for (int p = 0; p < size; ++p)
+		{
+			// position in tile units, tile centers sit at integers
+			const float f = (static_cast<float>(p) + 0.5f) / static_cast<float>(tile_size) - 0.5f;
+			const int lo  = static_cast<int>(std::floor(f));
+			t0[p]         = std::clamp(lo, 0, tiles - 1);
+			t1[p]         = std::clamp(lo + 1, 0, tiles - 1);
+			const float fraction = f - static_cast<float>(lo);
+			weight[p] = t0[p] == t1[p] ? 0u : static_cast<uint32_t>(std::lround(fraction * unit));
+			offset0[p] = t0[p] * 256;
+			offset1[p] = t1[p] * 256;
+		}
+	}
+
+	int begin(int tile) const { return tile * tile_size; }
+	int end(int tile, int size) const { return std::min(size, (tile + 1) * tile_size); }
+};
+
+//! Maps one row through the tables of its two nearest tile columns, row_tables are scaled by 1 << weight_bits
+void interpolate_row(const uint8_t* pixels, uint8_t* out, int width, const uint32_t* row_tables,
+                     const TileAxis& columns)
+{
+	// left * (unit - w) + right * w = left * unit + (right - left) * w, the difference may be negative
+	constexpr int shift      = 2 * weight_bits;
+	constexpr uint32_t round = 1u << (shift - 1);
+	int x                    = 0;
+#if defined(__AVX2__)
+	const int* table      = reinterpret_cast<const int*>(row_tables);
+	const __m256i rounding = _mm256_set1_epi32(static_cast<int>(round));
+	for (; x + 8 <= width; x += 8)
+	{
+		const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels + x));
+		const __m256i p     = _mm256_cvtepu8_epi32(bytes);
+		const __m256i i0    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns.offset0.data() + x));
+		const __m256i i1    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns.offset1.data() + x));
+		const __m256i w     = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns.weight.data() + x));
+		const __m256i left  = _mm256_i32gather_epi32(table, _mm256_add_epi32(i0, p), 4);
+		const __m256i right = _mm256_i32gather_epi32(table, _mm256_add_epi32(i1, p), 4);
+		__m256i value       = _mm256_mullo_epi32(_mm256_sub_epi32(right, left), w);
+		value = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(left, weight_bits), value), rounding);
+		value = _mm256_srli_epi32(value, shift);
+		const __m128i words =
+			_mm_packus_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(words, words));
+	}
+#endif
+	for (; x < width; ++x)
+	{
+		const uint32_t left  = row_tables[columns.offset0[x] + pixels[x]];
+		const uint32_t right = row_tables[columns.offset1[x] + pixels[x]];
+		const uint32_t value = (left << weight_bits) + (right - left) * columns.weight[x] + round;
+		out[x]               = static_cast<uint8_t>(value >> shift);
+	}
+}
+} // namespace
+
+ClaheProcessor::Table ClaheProcessor::clipped_table(Histogram hist, uint32_t num_pixels, float clip_limit)
+{
+	Table table{};
+	if (num_pixels == 0) return table;
+
+	const uint32_t limit =
+		std::max(1u, static_cast<uint32_t>(clip_limit * static_cast<float>(num_pixels) / 256.0f));
+	uint32_t excess = 0;
+	for (uint32_t& count : hist)
+	{
+		if (count <= limit) continue;
+		excess += count - limit;
+		count = limit;
+	}
+
+	// spread the excess evenly, the remainder in equal steps over the value range
+	const uint32_t share = excess / 256;
+	uint32_t remainder   = excess % 256;
+	const int step       = remainder > 0 ? std::max(1, static_cast<int>(256 / remainder)) : 256;
+	for (int v = 0; v < 256; ++v)
+	{
+		hist[v] += share;
+	}
+	for (int v = 0; v < 256 && remainder > 0; v += step, --remainder)
+	{
+		++hist[v];
+	}
+
+	uint64_t cumulative = 0;
+	for (int v = 0; v < 256; ++v)
+	{
+		cumulative += hist[v];
+		const uint64_t value = (cumulative * 255 + num_pixels / 2) / num_pixels;
+		table[v]             = static_cast<uint8_t>(std::min<uint64_t>(255, value));
+	}
+	return table;
+}
+
+GSImage ClaheProcessor::apply(const GSImage& image, int tiles, float clip_limit)
+{
+	if (image.empty() || tiles < 1 || tiles > max_tiles || !(clip_limit >= 1.0f)) return GSImage();
+
+	const int width  = image.width;
+	const int height = image.height;
+	const TileAxis columns(width, tiles);
+	const TileAxis rows(height, tiles);
+	const int num_tiles = columns.tiles * rows.tiles;
+
+	// one table per tile, tiles in parallel
+	std::vector<Table> tables(num_tiles);
+#pragma omp parallel for schedule(dynamic)
+	for (int t = 0; t < num_tiles; ++t)
+	{
+		const int tx      = t % columns.tiles;
+		const int ty      = t / columns.tiles;
+		const int x_begin = columns.begin(tx);
+		const int x_end   = columns.end(tx, width);
+		// two interleaved histograms, so runs of equal paper values do not serialize on one counter
+		Histogram even{};
+		Histogram odd{};
+		for (int y = rows.begin(ty); y < rows.end(ty, height); ++y)
+		{
+			const uint8_t* pixels = image.pixels.data() + static_cast<size_t>(y) * width;
+			int x                 = x_begin;
+			for (; x + 2 <= x_end; x += 2)
+			{
+				++even[pixels[x]];
+				++odd[pixels[x + 1]];
+			}
+			if (x < x_end) ++even[pixels[x]];
+		}
+		Histogram hist;
+		for (int v = 0; v < 256; ++v)
+		{
+			hist[v] = even[v] + odd[v];
+		}
+		const int tile_rows   = rows.end(ty, height) - rows.begin(ty);
+		const uint32_t pixels = static_cast<uint32_t>((x_end - x_begin) * tile_rows);
+		tables[t]             = clipped_table(hist, pixels, clip_limit);
+	}
+
+	GSImage output_image;
+	output_image.width     = width;
+	output_image.height    = height;
+	output_image.maxval    = image.maxval;
+	output_image.exif_data = image.exif_data;
+	output_image.pixels.resize(image.pixel_count());
+
+	constexpr uint32_t unit = 1u << weight_bits;
+#pragma omp parallel
+	{
+		// tables of the current row: the vertically interpolated tables of one tile row, scaled by unit.
+		// 32-bit entries, so the lookups can be gathered
+		std::vector<uint32_t> row_tables(static_cast<size_t>(columns.tiles) * 256);
+
+#pragma omp for schedule(static)
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t wy = rows.weight[y];
+			for (int tx = 0; tx < columns.tiles; ++tx)
+			{
+				const uint8_t* top    = tables[rows.t0[y] * columns.tiles + tx].data();
+				const uint8_t* bottom = tables[rows.t1[y] * columns.tiles + tx].data();
+				uint32_t* row_table   = row_tables.data() + static_cast<size_t>(tx) * 256;
+				for (int v = 0; v < 256; ++v)
+				{
+					row_table[v] = top[v] * (unit - wy) + bottom[v] * wy;
+				}
+			}
+
+			const uint8_t* pixels = image.pixels.data() + static_cast<size_t>(y) * width;
+			uint8_t* out          = output_image.pixels.data() + static_cast<size_t>(y) * width;
+			interpolate_row(pixels, out, width, row_tables.data(), columns);
+		}
+	}
+
+	return output_image;
+}
+} // namespace imgclean::processors
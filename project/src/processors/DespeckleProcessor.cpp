@@ -0,0 +1,179 @@
+#include "imgclean/processors/DespeckleProcessor.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+#include <vector>
+
+namespace imgclean::processors
+{
+namespace
+{
+//! Index of a run. A run covers at least one pixel and is followed by background, so images below
+//! 8 gigapixels have less than 2^32 runs.
+using Label = uint32_t;
+
+//! Ink pixels [begin, end) of one row
+struct Run
+{
+	int begin;
+	int end;
+};
+
+//! Calls fn(begin, end) for every run of ink pixels of a row, skips background 64 pixels at a time.
+//! The padding bits of a row are zero, so no run extends past the width.
+template <typename RunFn>
+void for_each_run(const uint64_t* row, size_t num_words, RunFn fn)
+{
+	constexpr int bits = BinaryImage::word_bits;
+	const size_t end_of_row = num_words * bits;
+
+	size_t x = 0;
+	while (x < end_of_row)
+	{
+		// first ink pixel at or after x
+		size_t k      = x / bits;
+		uint64_t word = row[k] & (~uint64_t(0) << (x % bits));
+		while (word == 0 && ++k < num_words) word = row[k];
+		if (word == 0) return;
+		const size_t begin = k * bits + std::countr_zero(word);
+
+		// first background pixel after begin
+		k    = begin / bits;
+		word = ~row[k] & (~uint64_t(0) << (begin % bits));
+		while (word == 0 && ++k < num_words) word = ~row[k];
+		const size_t end = word == 0 ? end_of_row : k * bits + std::countr_zero(word);
+
+		fn(static_cast<int>(begin), static_cast<int>(end));
+		x = end;
+	}
+}
+
+//! Clears the pixels [begin, end) of a row
+void clear_run(uint64_t* row, int begin, int end)
+{
+	constexpr int bits = BinaryImage::word_bits;
+	for (int x = begin; x < end;)
+	{
+		const int offset    = x % bits;
+		const int count     = std::min(bits - offset, end - x);
+		const uint64_t mask = (count == bits ? ~uint64_t(0) : (uint64_t(1) << count) - 1) << offset;
+		row[x / bits] &= ~mask;
+		x += count;
+	}
+}
+
+//! Root of a run, halves the path on the way. Every link points to a smaller label.
+Label find_root(std::vector<Label>& parent, Label i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i         = parent[i];
+	}
+	return i;
+}
+
+//! Joins the components of two runs under the smaller root
+void unite(std::vector<Label>& parent, Label a, Label b)
+{
+	a = find_root(parent, a);
+	b = find_root(parent, b);
+	if (a < b) parent[b] = a;
+	else if (b < a) parent[a] = b;
+}
+
+//! Joins the runs [above, current) of a row with the 8-connected runs [current, end) of the row below
+void connect_rows(const std::vector<Run>& runs, std::vector<Label>& parent, Label above, Label current, Label end)
+{
+	Label i = above;
+	Label j = current;
+	while (i < current && j < end)
+	{
+		// overlapping or diagonally touching
+		if (runs[i].end >= runs[j].begin && runs[j].end >= runs[i].begin) unite(parent, i, j);
+		// the run that ends first cannot touch any later run of the other row
+		if (runs[i].end < runs[j].end) ++i;
+		else ++j;
+	}
+}
+} // namespace
+
+BinaryImage DespeckleProcessor::apply(const BinaryImage& image, int min_area)
+{
+	BinaryImage output_image = image;
+	remove_speckles(output_image, min_area);
+	return output_image;
+}
+
+void DespeckleProcessor::remove_speckles(BinaryImage& image, int min_area)
+{
+	if (image.empty() || min_area <= 1) return;
+
+	const int height       = image.height;
+	const size_t num_words = image.words_per_row;
+	const int num_bands    = (height + band_rows - 1) / band_rows;
+
+	// count the runs of every row, row_start[y] is the label of the first run of row y
+	std::vector<Label> row_start(static_cast<size_t>(height) + 1, 0);
+#pragma omp parallel for schedule(static)
+	for (int y = 0; y < height; ++y)
+	{
+		Label count = 0;
+		for_each_run(image.row(y), num_words, [&](int, int) { ++count; });
+		row_start[y + 1] = count;
+	}
+	std::partial_sum(row_start.begin(), row_start.end(), row_start.begin());
+	const Label num_runs = row_start[height];
+	if (num_runs == 0) return;
+
+	// label every band on its own, the links of a band stay within its labels
+	std::vector<Run> runs(num_runs);
+	std::vector<Label> parent(num_runs);
+#pragma omp parallel for schedule(dynamic)
+	for (int band = 0; band < num_bands; ++band)
+	{
+		const int y_begin = band * band_rows;
+		const int y_end   = std::min(height, y_begin + band_rows);
+		for (int y = y_begin; y < y_end; ++y)
+		{
+			Label next = row_start[y];
+			for_each_run(image.row(y), num_words,
+			             [&](int begin, int end)
+			             {
+				             runs[next]   = {begin, end};
+				             parent[next] = next;
+				             ++next;
+			             });
+			if (y > y_begin) connect_rows(runs, parent, row_start[y - 1], row_start[y], row_start[y + 1]);
+		}
+	}
+
+	// merge the components across the band borders
+	for (int band = 1; band < num_bands; ++band)
+	{
+		const int y = band * band_rows;
+		connect_rows(runs, parent, row_start[y - 1], row_start[y], row_start[y + 1]);
+	}
+
+	// flatten in label order, the parent of a run is flat before the run itself,
+	// and sum the run lengths at the roots
+	std::vector<uint32_t> area(num_runs, 0);
+	for (Label i = 0; i < num_runs; ++i)
+	{
+		parent[i] = parent[parent[i]];
+		area[parent[i]] += static_cast<uint32_t>(runs[i].end - runs[i].begin);
+	}
+
+	const uint32_t min_pixels = static_cast<uint32_t>(min_area);
+#pragma omp parallel for schedule(static)
+	for (int y = 0; y < height; ++y)
+	{
+		uint64_t* row = image.row(y);
+		for (Label i = row_start[y]; i < row_start[y + 1]; ++i)
+		{
+			if (area[parent[i]] < min_pixels) clear_run(row, runs[i].begin, runs[i].end);
+		}
+	}
+}
+} // namespace imgclean::processors
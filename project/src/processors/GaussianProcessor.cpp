@@ -0,0 +1,72 @@
+#include "imgclean/processors/GaussianProcessor.hpp"
+
+#include "imgclean/processors/BoxSumEngine.hpp"
+#include "imgclean/processors/WindowKernel.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace imgclean::processors
+{
+std::array<int, GaussianProcessor::num_boxes> GaussianProcessor::box_sizes(float sigma)
+{
+	// n boxes of width w have the variance n * (w^2 - 1) / 12. Take the odd width just below the ideal
+	// one and the next odd width above, and choose how many boxes get the smaller one (Kovesi, 2010).
+	const double n        = num_boxes;
+	const double variance = static_cast<double>(sigma) * sigma;
+	int lower             = static_cast<int>(std::floor(std::sqrt(12.0 * variance / n + 1.0)));
+	if (lower % 2 == 0) --lower;
+	lower          = std::clamp(lower, 1, max_window_size - 2);
+	const double l = lower;
+	const long num_lower = std::lround((12.0 * variance - n * l * l - 4.0 * n * l - 3.0 * n) / (-4.0 * l - 4.0));
+
+	std::array<int, num_boxes> sizes;
+	for (int i = 0; i < num_boxes; ++i)
+	{
+		sizes[i] = i < num_lower ? lower : lower + 2;
+	}
+	return sizes;
+}
+
+GSImage GaussianProcessor::box_filter(const GSImage& image, int window_size)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return GSImage();
+
+	GSImage output_image;
+	output_image.width     = image.width;
+	output_image.height    = image.height;
+	output_image.maxval    = image.maxval;
+	output_image.exif_data = image.exif_data;
+	output_image.pixels.resize(image.pixel_count());
+
+	const int width = image.width;
+	auto mean_row   = [&](int y, const uint32_t* sums, const uint64_t*, const uint32_t* counts)
+	{
+		uint8_t* out = output_image.pixels.data() + static_cast<size_t>(y) * width;
+		// exact below 2^24, the sums of windows up to 255 x 255
+		for (int x = 0; x < width; ++x)
+		{
+			const float mean = static_cast<float>(sums[x]) / static_cast<float>(counts[x]);
+			out[x]           = static_cast<uint8_t>(mean + 0.5f);
+		}
+	};
+	auto kernel = [&](auto half)
+	{
+		BoxSumEngine::for_each_row<decltype(half)::value>(image, window_size / 2, false, mean_row);
+	};
+	dispatch_half_window(window_size / 2, kernel);
+
+	return output_image;
+}
+
+GSImage GaussianProcessor::apply(const GSImage& image, float sigma)
+{
+	if (image.empty() || !(sigma > 0.0f)) return GSImage();
+
+	GSImage output_image = image;
+	for (int window_size : box_sizes(sigma))
+	{
+		if (window_size > 1) output_image = box_filter(output_image, window_size);
+	}
+	return output_image;
+}
+} // namespace imgclean::processors
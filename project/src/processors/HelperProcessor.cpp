@@ -0,0 +1,293 @@
+#include "imgclean/processors/HelperProcessor.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE4_1__)
+# include <immintrin.h>
+#endif
+
+namespace imgclean::processors
+{
+namespace
+{
+//! 0.299, 0.587 and 0.114 in Q16, they sum up to exactly 1 << 16
+constexpr uint32_t weight_r = 19595;
+constexpr uint32_t weight_g = 38470;
+constexpr uint32_t weight_b = 7471;
+//! Fraction bits of the rescale reciprocal, gray * reciprocal <= (255 << 24) + max_gray still fits in 32 bits
+constexpr int rescale_shift = 24;
+//! Pixels per parallel work item
+constexpr size_t chunk_pixels = 1u << 16;
+//! Pixels per block of the row-wise conversion, the 16-bit luma block stays in L1
+constexpr size_t row_block_pixels = 1024;
+
+//! Rounded fixed-point luma of one RGB pixel
+inline uint32_t luma(uint32_t r, uint32_t g, uint32_t b)
+{
+	return (weight_r * r + weight_g * g + weight_b * b + (1u << 15)) >> 16;
+}
+
+#if defined(__SSE4_1__)
+//! Byte shuffle that moves the 16-bit element src[k] of a register to lane k, -1 clears the lane
+inline __m128i gather_mask(const int (&src)[8])
+{
+	alignas(16) int8_t bytes[16];
+	for (int k = 0; k < 8; ++k)
+	{
+		bytes[2 * k]     = src[k] < 0 ? int8_t(-128) : static_cast<int8_t>(2 * src[k]);
+		bytes[2 * k + 1] = src[k] < 0 ? int8_t(-128) : static_cast<int8_t>(2 * src[k] + 1);
+	}
+	return _mm_load_si128(reinterpret_cast<const __m128i*>(bytes));
+}
+
+//! Weighted sum of 8 channel vectors, returns 8 rounded 16-bit lumas
+inline __m128i luma8(__m128i r, __m128i g, __m128i b)
+{
+# if defined(__AVX2__)
+	const __m256i rounding = _mm256_set1_epi32(1 << 15);
+	__m256i acc            = _mm256_mullo_epi32(_mm256_cvtepu16_epi32(r), _mm256_set1_epi32(weight_r));
+	acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(_mm256_cvtepu16_epi32(g), _mm256_set1_epi32(weight_g)));
+	acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(_mm256_cvtepu16_epi32(b), _mm256_set1_epi32(weight_b)));
+	acc = _mm256_srli_epi32(_mm256_add_epi32(acc, rounding), 16);
+	return _mm_packus_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+# else
+	const __m128i rounding = _mm_set1_epi32(1 << 15);
+	auto half              = [&](__m128i r4, __m128i g4, __m128i b4)
+	{
+		__m128i acc = _mm_mullo_epi32(r4, _mm_set1_epi32(weight_r));
+		acc         = _mm_add_epi32(acc, _mm_mullo_epi32(g4, _mm_set1_epi32(weight_g)));
+		acc         = _mm_add_epi32(acc, _mm_mullo_epi32(b4, _mm_set1_epi32(weight_b)));
+		return _mm_srli_epi32(_mm_add_epi32(acc, rounding), 16);
+	};
+	const __m128i lo = half(_mm_cvtepu16_epi32(r), _mm_cvtepu16_epi32(g), _mm_cvtepu16_epi32(b));
+	const __m128i hi = half(_mm_cvtepu16_epi32(_mm_srli_si128(r, 8)), _mm_cvtepu16_epi32(_mm_srli_si128(g, 8)),
+	                        _mm_cvtepu16_epi32(_mm_srli_si128(b, 8)));
+	return _mm_packus_epi32(lo, hi);
+# endif
+}
+#endif // __SSE4_1__
+
+//! Luma of n interleaved RGB pixels into out, returns the largest luma
+template <typename T>
+uint16_t luma_pass(const uint16_t* rgb, T* out, size_t n)
+{
+	size_t i          = 0;
+	uint16_t max_gray = 0;
+
+#if defined(__SSE4_1__)
+	// 8 pixels = 3 registers: R0G0B0R1G1B1R2G2 | B2R3G3B3R4G4B4R5 | G5B5R6G6B6R7G7B7
+	const __m128i r0 = gather_mask({0, 3, 6, -1, -1, -1, -1, -1});
+	const __m128i r1 = gather_mask({-1, -1, -1, 1, 4, 7, -1, -1});
+	const __m128i r2 = gather_mask({-1, -1, -1, -1, -1, -1, 2, 5});
+	const __m128i g0 = gather_mask({1, 4, 7, -1, -1, -1, -1, -1});
+	const __m128i g1 = gather_mask({-1, -1, -1, 2, 5, -1, -1, -1});
+	const __m128i g2 = gather_mask({-1, -1, -1, -1, -1, 0, 3, 6});
+	const __m128i b0 = gather_mask({2, 5, -1, -1, -1, -1, -1, -1});
+	const __m128i b1 = gather_mask({-1, -1, 0, 3, 6, -1, -1, -1});
+	const __m128i b2 = gather_mask({-1, -1, -1, -1, -1, 1, 4, 7});
+
+	__m128i vmax = _mm_setzero_si128();
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m128i* src = reinterpret_cast<const __m128i*>(rgb + i * 3);
+		const __m128i v0   = _mm_loadu_si128(src + 0);
+		const __m128i v1   = _mm_loadu_si128(src + 1);
+		const __m128i v2   = _mm_loadu_si128(src + 2);
+
+		const __m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, r0), _mm_shuffle_epi8(v1, r1)),
+		                               _mm_shuffle_epi8(v2, r2));
+		const __m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, g0), _mm_shuffle_epi8(v1, g1)),
+		                               _mm_shuffle_epi8(v2, g2));
+		const __m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, b0), _mm_shuffle_epi8(v1, b1)),
+		                               _mm_shuffle_epi8(v2, b2));
+
+		const __m128i gray = luma8(r, g, b);
+		vmax               = _mm_max_epu16(vmax, gray);
+		if constexpr (sizeof(T) == 1)
+		{
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(gray, gray));
+		}
+		else
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), gray);
+		}
+	}
+
+	alignas(16) uint16_t lanes[8];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), vmax);
+	max_gray = *std::max_element(lanes, lanes + 8);
+#endif // __SSE4_1__
+
+	// scalar fallback and tail
+	for (; i < n; ++i)
+	{
+		const uint32_t gray = luma(rgb[i * 3 + 0], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+		out[i]              = static_cast<T>(gray);
+		max_gray            = std::max(max_gray, static_cast<uint16_t>(gray));
+	}
+	return max_gray;
+}
+
+//! out = round(in * 255 / max_gray) via an integer reciprocal multiply
+template <typename T>
+void rescale_pass(const T* in, uint8_t* out, size_t n, uint32_t reciprocal)
+{
+	constexpr uint32_t rounding = 1u << (rescale_shift - 1);
+#pragma omp simd
+	for (size_t i = 0; i < n; ++i)
+	{
+		out[i] = static_cast<uint8_t>((in[i] * reciprocal + rounding) >> rescale_shift);
+	}
+}
+
+//! Reciprocal of the rescale to 0-255.
+//! Rounded up, so that exact .5 results round up like the float formula, the excess stays below 2^-16.
+uint32_t rescale_reciprocal(uint16_t max_gray)
+{
+	if (max_gray == 0) max_gray = 1; // avoid division by zero
+	return static_cast<uint32_t>(((255ull << rescale_shift) + max_gray - 1) / max_gray);
+}
+
+//! Both passes for a luma type wide enough for the input samples
+template <typename T>
+void convert(const PPMImage& image, T* luma_buf, uint8_t* out)
+{
+	const size_t num_pixels = image.pixel_count();
+	const size_t num_chunks = (num_pixels + chunk_pixels - 1) / chunk_pixels;
+	const uint16_t* rgb     = image.pixels.data();
+
+	// pass 1: luma and its maximum
+	uint16_t max_gray = 0;
+#pragma omp parallel for schedule(static) reduction(max : max_gray)
+	for (size_t c = 0; c < num_chunks; ++c)
+	{
+		const size_t begin = c * chunk_pixels;
+		const size_t n     = std::min(chunk_pixels, num_pixels - begin);
+		max_gray           = std::max(max_gray, luma_pass(rgb + begin * 3, luma_buf + begin, n));
+	}
+
+	// pass 2: rescale to 0-255
+	const uint32_t reciprocal = rescale_reciprocal(max_gray);
+#pragma omp parallel for schedule(static)
+	for (size_t c = 0; c < num_chunks; ++c)
+	{
+		const size_t begin = c * chunk_pixels;
+		const size_t n     = std::min(chunk_pixels, num_pixels - begin);
+		rescale_pass(luma_buf + begin, out + begin, n, reciprocal);
+	}
+}
+} // namespace
+
+GSImage HelperProcessor::rgb_to_linear_grayscale(const PPMImage& image)
+{
+	GSImage gray_image;
+	gray_image.width     = image.width;
+	gray_image.height    = image.height;
+	gray_image.exif_data = image.exif_data; // preserve EXIF data
+	gray_image.maxval    = 255;
+	gray_image.pixels.resize(image.pixel_count());
+
+	if (image.maxval <= 255)
+	{
+		// luma fits in 8 bits -> rescale in place
+		convert(image, gray_image.pixels.data(), gray_image.pixels.data());
+	}
+	else
+	{
+		std::vector<uint16_t> luma_buf(image.pixel_count());
+		convert(image, luma_buf.data(), gray_image.pixels.data());
+	}
+
+	return gray_image;
+}
+
+uint16_t HelperProcessor::max_luma(const PPMImage& image)
+{
+	const size_t num_pixels = image.pixel_count();
+	const size_t num_chunks = (num_pixels + row_block_pixels - 1) / row_block_pixels;
+	const uint16_t* rgb     = image.pixels.data();
+
+	// the luma block is discarded, only its maximum is kept
+	uint16_t max_gray = 0;
+#pragma omp parallel for schedule(static) reduction(max : max_gray)
+	for (size_t c = 0; c < num_chunks; ++c)
+	{
+		uint16_t block[row_block_pixels];
+		const size_t begin = c * row_block_pixels;
+		const size_t n     = std::min(row_block_pixels, num_pixels - begin);
+		max_gray           = std::max(max_gray, luma_pass(rgb + begin * 3, block, n));
+	}
+	return max_gray;
+}
+
+void HelperProcessor::linear_grayscale_row(const uint16_t* rgb, size_t n, uint16_t max_luma, uint8_t* out)
+{
+	const uint32_t reciprocal = rescale_reciprocal(max_luma);
+	uint16_t block[row_block_pixels];
+	for (size_t begin = 0; begin < n; begin += row_block_pixels)
+	{
+		const size_t count = std::min(row_block_pixels, n - begin);
+		luma_pass(rgb + begin * 3, block, count);
+		// a brighter sample than max_luma would wrap around in the rescale, it becomes white instead
+#pragma omp simd
+		for (size_t i = 0; i < count; ++i)
+		{
+			block[i] = std::min(block[i], max_luma);
+		}
+		rescale_pass(block, out + begin, count, reciprocal);
+	}
+}
+
+GSImage HelperProcessor::binary_to_grayscale(const BinaryImage& binary_image)
+{
+	GSImage gray_image;
+	gray_image.width     = binary_image.width;
+	gray_image.height    = binary_image.height;
+	gray_image.exif_data = binary_image.exif_data;
+	gray_image.maxval    = 255;
+	if (binary_image.empty()) return gray_image;
+	gray_image.pixels.resize(binary_image.pixel_count());
+
+	const int width  = binary_image.width;
+	const int height = binary_image.height;
+#pragma omp parallel for schedule(static)
+	for (int y = 0; y < height; ++y)
+	{
+		const uint64_t* words = binary_image.row(y);
+		uint8_t* out          = gray_image.pixels.data() + static_cast<size_t>(y) * width;
+		for (int x0 = 0; x0 < width; x0 += BinaryImage::word_bits)
+		{
+			const uint64_t word = words[x0 / BinaryImage::word_bits];
+			const int count     = std::min(BinaryImage::word_bits, width - x0);
+			for (int b = 0; b < count; ++b)
+			{
+				out[x0 + b] = ((word >> b) & 1u) ? 0 : 255;
+			}
+		}
+	}
+
+	return gray_image;
+}
+
+BinaryImage HelperProcessor::grayscale_to_binary(const GSImage& gray_image, uint8_t threshold)
+{
+	BinaryImage binary_image;
+	binary_image.exif_data = gray_image.exif_data;
+	if (gray_image.empty()) return binary_image;
+	binary_image.resize(gray_image.width, gray_image.height);
+
+	const int width  = gray_image.width;
+	const int height = gray_image.height;
+#pragma omp parallel for schedule(static)
+	for (int y = 0; y < height; ++y)
+	{
+		const uint8_t* pixels = gray_image.pixels.data() + static_cast<size_t>(y) * width;
+		BinaryImage::pack_row(binary_image.row(y), width, [&](int x) { return pixels[x] < threshold; });
+	}
+
+	return binary_image;
+}
+
+} // namespace imgclean::processors
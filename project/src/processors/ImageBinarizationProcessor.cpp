@@ -1,110 +1,236 @@
 #include "imgclean/processors/ImageBinarizationProcessor.hpp"
-
+#include "imgclean/processors/BoxSumEngine.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/LocalStatistics.hpp"
+#include "imgclean/processors/LocalThreshold.hpp"
+#include "imgclean/processors/ThresholdSurface.hpp"
+#include "imgclean/processors/WindowKernel.hpp"
+
+#include <algorithm>
 #include <cmath>
 #include <limits>
-#include <numeric>
+#include <vector>
 
 namespace imgclean::processors
 {
+namespace
+{
+//! Page-wide values the threshold is normalized with
+struct PageStatistics
+{
+	float global_mean;
+	float min_stddev;
+	float max_stddev;
+
+	//! Threshold of a pixel from the statistics of its window
+	float threshold(float mean, float stddev) const
+	{
+		// adaptive_stddev
+		float adaptive_stddev = 0.0;
+		if (max_stddev > min_stddev)
+		{
+			adaptive_stddev = (stddev - min_stddev) / (max_stddev - min_stddev);
+		}
 
-GSImage ImageBinarizationProcessor::apply(const GSImage& image)
+		return stddev - (mean * mean - stddev) / ((global_mean + stddev) * (adaptive_stddev + stddev));
+	}
+};
+
+//! Smallest and largest stddev over all windows of the page from the rolling sums. The per-row extrema are
+//! combined after the parallel pass, min/max are exact, so the result does not depend on the number of threads.
+void stddev_extrema(const LocalStatisticsEngine& windows, float& min_stddev, float& max_stddev)
 {
-	if (image.empty()) return GSImage();
+	const GSImage& image = windows.source();
+	std::vector<double> row_min_var(image.height);
+	std::vector<double> row_max_var(image.height);
 
-	const int width             = image.width;
-	const int height            = image.height;
-	const size_t num_pixels     = image.pixels.size();
-	const unsigned char* pixels = image.pixels.data();
+	// the extrema of the variance give those of the stddev, so the square root is only taken twice
+	auto row_extrema = [&](int y, const auto& row)
+	{
+		double min_var = std::numeric_limits<double>::max();
+		double max_var = std::numeric_limits<double>::lowest();
+		for (int x = 0; x < image.width; ++x)
+		{
+			const double var = row.variance(x);
+			min_var          = std::min(min_var, var);
+			max_var          = std::max(max_var, var);
+		}
+		row_min_var[y] = min_var;
+		row_max_var[y] = max_var;
+	};
+	windows.for_each_sliding_row(row_extrema);
 
-	std::vector<float> windows_mean(num_pixels);
-	std::vector<float> windows_stddev(num_pixels);
-	float w_min_stddev = std::numeric_limits<float>::max();
-	float w_max_stddev = std::numeric_limits<float>::min();
+	min_stddev = LocalStatistics::stddev_of(*std::min_element(row_min_var.begin(), row_min_var.end()));
+	max_stddev = LocalStatistics::stddev_of(*std::max_element(row_max_var.begin(), row_max_var.end()));
+}
 
-	for (int j = 0; j < height; ++j)
+//! Thresholds with the integral images: a single lookup pass stores mean and stddev of every window together
+//! with the stddev extrema of each row, the thresholds then read the stored values. Looking every window up
+//! twice, like the rolling sums are run twice, costs more than the two float planes.
+BinaryImage threshold_stored(const LocalStatisticsEngine& windows, PageStatistics& page)
+{
+	const GSImage& image    = windows.source();
+	const int width         = image.width;
+	const int height        = image.height;
+	const size_t num_pixels = image.pixels.size();
+
+	std::vector<float> mean(num_pixels);
+	std::vector<float> stddev(num_pixels);
+	// min/max are exact, so the result does not depend on the number of threads
+	std::vector<float> row_min_stddev(height, std::numeric_limits<float>::max());
+	std::vector<float> row_max_stddev(height, std::numeric_limits<float>::lowest());
+
+	auto store_row = [&](int y, const auto& row)
 	{
-		for (int i = 0; i < width; ++i)
+		float* row_mean   = mean.data() + static_cast<size_t>(y) * width;
+		float* row_stddev = stddev.data() + static_cast<size_t>(y) * width;
+		float min_stddev  = std::numeric_limits<float>::max();
+		float max_stddev  = std::numeric_limits<float>::lowest();
+		for (int x = 0; x < width; ++x)
 		{
-			int x1 = std::max(0, i - half_window);
-			int y1 = std::max(0, j - half_window);
-			int x2 = std::min(width - 1, i + half_window);
-			int y2 = std::min(height - 1, j + half_window);
-
-			float tmp_acc = 0;
-			for (int y = y1; y <= y2; ++y)
-			{
-				for (int x = x1; x <= x2; ++x)
-				{
-					tmp_acc += pixels[y * width + x];
-				}
-			}
-			float cur_mean              = tmp_acc / ((x2 - x1 + 1) * (y2 - y1 + 1));
-			windows_mean[j * width + i] = cur_mean;
-
-			float cur_stddev = 0.0;
-			for (int y = y1; y <= y2; ++y)
-			{
-				for (int x = x1; x <= x2; ++x)
-				{
-					float diff = pixels[y * width + x] - cur_mean;
-					cur_stddev += diff * diff;
-				}
-			}
-
-			cur_stddev = std::sqrt(cur_stddev / ((x2 - x1 + 1) * (y2 - y1 + 1)));
-
-			if (cur_stddev > w_max_stddev)
-			{
-				w_max_stddev = cur_stddev;
-			}
-
-			if (cur_stddev < w_min_stddev)
-			{
-				w_min_stddev = cur_stddev;
-			}
-
-			windows_stddev[j * width + i] = cur_stddev;
+			float cur_mean   = 0.0f;
+			float cur_stddev = 0.0f;
+			row.stats(x, cur_mean, cur_stddev);
+			row_mean[x]   = cur_mean;
+			row_stddev[x] = cur_stddev;
+			min_stddev    = std::min(min_stddev, cur_stddev);
+			max_stddev    = std::max(max_stddev, cur_stddev);
 		}
+		row_min_stddev[y] = min_stddev;
+		row_max_stddev[y] = max_stddev;
+	};
+	windows.for_each_integral_row(store_row);
+	page.min_stddev = *std::min_element(row_min_stddev.begin(), row_min_stddev.end());
+	page.max_stddev = *std::max_element(row_max_stddev.begin(), row_max_stddev.end());
+
+	BinaryImage output_image;
+	output_image.resize(width, height);
+	output_image.exif_data = image.exif_data;
+
+#pragma omp parallel for schedule(static)
+	for (int y = 0; y < height; ++y)
+	{
+		const size_t row_offset = static_cast<size_t>(y) * width;
+		const uint8_t* pixels   = image.pixels.data() + row_offset;
+		auto is_ink             = [&](int x)
+		{
+			return pixels[x] < page.threshold(mean[row_offset + x], stddev[row_offset + x]);
+		};
+		BinaryImage::pack_row(output_image.row(y), width, is_ink);
 	}
+	return output_image;
+}
 
-	// at this point: g_mean, w_min;max_stddev
+//! Exact sum over all pixels, an integer total does not depend on the summation order
+uint64_t pixel_total(const GSImage& image)
+{
+	const size_t num_pixels     = image.pixels.size();
+	const unsigned char* pixels = image.pixels.data();
+	uint64_t pixel_sum          = 0;
+#pragma omp parallel for reduction(+ : pixel_sum)
+	for (size_t i = 0; i < num_pixels; ++i)
+	{
+		pixel_sum += pixels[i];
+	}
+	return pixel_sum;
+}
+} // namespace
 
-	// prepare output
-	GSImage output_image;
-	output_image.width     = width;
-	output_image.height    = height;
-	output_image.maxval    = image.maxval;
-	output_image.exif_data = image.exif_data;
-	output_image.pixels.resize(num_pixels);
+GSImage ImageBinarizationProcessor::apply(const GSImage& image, WindowEngine engine, int window_size)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return GSImage();
+
+	GSImage output_image = HelperProcessor::binary_to_grayscale(apply_binary(image, engine, window_size));
+	output_image.maxval  = image.maxval;
+	return output_image;
+}
+
+BinaryImage ImageBinarizationProcessor::apply_binary(const GSImage& image, WindowEngine engine, int window_size)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return BinaryImage();
+
+	// integer total -> unlike a float accumulation the mean does not depend on the summation order
+	const double num_pixels = static_cast<double>(image.pixels.size());
+	PageStatistics page;
+	page.global_mean = static_cast<float>(static_cast<double>(pixel_total(image)) / num_pixels);
+
+	const LocalStatisticsEngine windows(image, engine, window_size);
+	if (engine == WindowEngine::INTEGRAL_IMAGE) return threshold_stored(windows, page);
+
+	// two passes over the rolling sums: the stddev extrema of the page, then the thresholds.
+	// Neither keeps a full-frame mean or stddev.
+	stddev_extrema(windows, page.min_stddev, page.max_stddev);
+
+	auto is_ink = [&](float pixel, float mean, float stddev) { return pixel < page.threshold(mean, stddev); };
+	return threshold_local(windows, is_ink);
+}
 
-	const float global_mean = std::accumulate(pixels, pixels + num_pixels, 0.0f) / static_cast<float>(num_pixels);
+BinaryImage ImageBinarizationProcessor::apply_approximate(const GSImage& image, WindowEngine engine, int window_size,
+                                                          int grid_factor)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return BinaryImage();
+	if (!ThresholdSurface::is_valid_factor(grid_factor)) return BinaryImage();
+	// every pixel is a grid point, the exact pass skips the surface
+	if (grid_factor == 1) return apply_binary(image, engine, window_size);
+
+	const int half_window = window_size / 2;
 
-	// Iterate again for binarization
-	for (int j = 0; j < height; ++j)
+	// mean and stddev at the grid points, the stddev surface is turned into the thresholds below
+	ThresholdSurface mean(image.width, image.height, grid_factor);
+	ThresholdSurface surface(image.width, image.height, grid_factor);
+
+	uint64_t pixel_sum = 0;
+	if (engine == WindowEngine::INTEGRAL_IMAGE)
 	{
-		for (int i = 0; i < width; ++i)
+		const LocalStatistics stats = LocalStatistics::compute(image);
+		const int width             = image.width;
+		const int height            = image.height;
+		auto sample = [&](int i, int j, int x, int y)
+		{
+			const int x1 = std::max(0, x - half_window);
+			const int x2 = std::min(width - 1, x + half_window);
+			const int y1 = std::max(0, y - half_window);
+			const int y2 = std::min(height - 1, y + half_window);
+			stats.window(x1, y1, x2, y2, mean.at(i, j), surface.at(i, j));
+		};
+		surface.for_each_point(sample);
+		pixel_sum = stats.sum.total();
+	}
+	else
+	{
+		auto sample = [&](int i, int j, uint32_t sum, uint64_t sum_sq, uint32_t count)
+		{
+			LocalStatistics::from_sums(sum, sum_sq, count, mean.at(i, j), surface.at(i, j));
+		};
+		auto kernel = [&](auto half)
 		{
-			const size_t index        = j * width + i;
-			const float current_value = windows_stddev[index];
-
-			// adaptive_stddev
-			float adaptive_stddev = 0.0;
-			if (w_max_stddev > w_min_stddev)
-			{
-				adaptive_stddev = (current_value - w_min_stddev) / (w_max_stddev - w_min_stddev);
-			}
-
-			// threshold calculation
-			float threshold = current_value -
-			                  (windows_mean[index] * windows_mean[index] - current_value) /
-			                          ((global_mean + current_value) * (adaptive_stddev + current_value));
-
-			// binarization
-			output_image.pixels[index] = (pixels[index] < threshold) ? 0 : 255;
+			surface.for_each_sample<decltype(half)::value>(image, half_window, true, sample);
+		};
+		dispatch_half_window(half_window, kernel);
+		pixel_sum = pixel_total(image);
+	}
+
+	// the page normalization only sees the sampled windows
+	const double num_pixels = static_cast<double>(image.pixels.size());
+	PageStatistics page;
+	page.global_mean = static_cast<float>(static_cast<double>(pixel_sum) / num_pixels);
+	page.min_stddev  = std::numeric_limits<float>::max();
+	page.max_stddev  = std::numeric_limits<float>::lowest();
+	for (int j = 0; j < surface.rows(); ++j)
+	{
+		for (int i = 0; i < surface.columns(); ++i)
+		{
+			page.min_stddev = std::min(page.min_stddev, surface.at(i, j));
+			page.max_stddev = std::max(page.max_stddev, surface.at(i, j));
 		}
 	}
 
-	return output_image;
+	auto to_threshold = [&](int i, int j, int, int)
+	{
+		surface.at(i, j) = page.threshold(mean.at(i, j), surface.at(i, j));
+	};
+	surface.for_each_point(to_threshold);
+	return surface.binarize(image);
 }
 
 } // namespace imgclean::processors
@@ -1,62 +1,174 @@
 #include "imgclean/processors/IntegralImageProcessor.hpp"
+#include "imgclean/processors/FusedThreshold.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/IntegralImage.hpp"
+#include "imgclean/processors/ThresholdSurface.hpp"
+#include "imgclean/processors/WindowKernel.hpp"
 
-#include <cstdio>
-#include <vector>
+#include <algorithm>
 
 namespace imgclean
 {
 namespace processors
 {
-GSImage IntegralImageProcessor::apply(const GSImage& image)
+namespace
 {
-	if (image.empty()) return GSImage();
+//! Rule of all engines: true if the pixel is darker than t times the mean of the window
+auto below_mean(float t)
+{
+	// sum keeps the type of the engine, a 32-bit sum converts to float faster
+	return [t](float pixel, auto sum, uint32_t count)
+	{
+		float local_mean = static_cast<float>(sum) / count;
+		return pixel < t * local_mean;
+	};
+}
+
+//! Thresholds every row against its window sums from rolling column sums, no full-frame integral image
+template <int Half>
+void threshold_sliding(const GSImage& image, BinaryImage& output_image, int half_window, float t)
+{
+	const int width = image.width;
+
+	//! Thresholds row j against its window sums
+	auto threshold_row = [&](int j, const uint32_t* sums, const uint64_t*, const uint32_t* counts)
+	{
+		const uint8_t* pixels = image.pixels.data() + static_cast<size_t>(j) * width;
+		const auto rule       = below_mean(t);
+		auto is_ink           = [&](int i) { return rule(static_cast<float>(pixels[i]), sums[i], counts[i]); };
+		BinaryImage::pack_row(output_image.row(j), width, is_ink);
+	};
+
+	BoxSumEngine::for_each_row<Half>(image, half_window, false, threshold_row);
+}
+
+//! Thresholds every pixel against its window sum read from the integral image
+template <int Half>
+void threshold_integral(const GSImage& image, const TiledIntegralImage& integral, BinaryImage& output_image,
+                        int half_window, float t)
+{
+	const int width  = image.width;
+	const int height = image.height;
+	const int half   = Half > 0 ? Half : half_window;
 
-	// compute the integral image
-	std::vector<uint32_t> integral(image.width * image.height, 0);
-	for (int y = 0; y < image.height; ++y)
+	// row-major threshold pass, rows are independent
+#pragma omp parallel for schedule(static)
+	for (int j = 0; j < height; ++j)
 	{
-		for (int x = 0; x < image.width; ++x)
+		const int y1          = std::max(0, j - half);
+		const int y2          = std::min(height - 1, j + half);
+		const uint8_t* pixels = image.pixels.data() + static_cast<size_t>(j) * width;
+		const auto rule       = below_mean(t);
+
+		//! True if pixel i is darker than the scaled local mean
+		auto is_ink = [&](int i)
 		{
-			int idx             = y * image.width + x;
-			uint32_t left       = (x > 0) ? integral[y * image.width + (x - 1)] : 0;
-			uint32_t above      = (y > 0) ? integral[(y - 1) * image.width + x] : 0;
-			uint32_t above_left = (y > 0 && x > 0) ? integral[(y - 1) * image.width + (x - 1)] : 0;
-
-			integral[y * image.width + x] = static_cast<uint32_t>(image.pixels[idx]) + left + above -
-			                                above_left;
-		}
+			const int x1         = std::max(0, i - half);
+			const int x2         = std::min(width - 1, i + half);
+			const uint32_t count = static_cast<uint32_t>((x2 - x1 + 1) * (y2 - y1 + 1));
+			return rule(static_cast<float>(pixels[i]), integral.box_sum(x1, y1, x2, y2), count);
+		};
+		BinaryImage::pack_row(output_image.row(j), width, is_ink);
 	}
+}
+} // namespace
+
+GSImage IntegralImageProcessor::apply(const GSImage& image, WindowEngine engine, int window_size, float t)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return GSImage();
+
+	GSImage output_image = HelperProcessor::binary_to_grayscale(apply_binary(image, engine, window_size, t));
+	output_image.maxval  = image.maxval;
+	return output_image;
+}
+
+BinaryImage IntegralImageProcessor::apply_binary(const GSImage& image, WindowEngine engine, int window_size, float t)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return BinaryImage();
+
+	const int half_window = window_size / 2;
 
-	GSImage output_image;
-	output_image.width  = image.width;
-	output_image.height = image.height;
-	output_image.maxval = image.maxval;
+	BinaryImage output_image;
+	output_image.resize(image.width, image.height);
 	output_image.exif_data = image.exif_data;
-	output_image.pixels.resize(image.width * image.height);
 
-	for (int i = 0; i < image.width; ++i)
+	if (engine == WindowEngine::SLIDING_WINDOW)
 	{
-		for (int j = 0; j < image.height; ++j)
+		auto kernel = [&](auto half)
 		{
-			int x1     = std::max(0, i - half_window);
-			int y1     = std::max(0, j - half_window);
-			int x2     = std::min(image.width - 1, i + half_window);
-			int y2     = std::min(image.height - 1, j + half_window);
-			int count  = (x2 - x1 + 1) * (y2 - y1 + 1);
-			uint32_t A = integral[y2 * image.width + x2];
-			uint32_t B = (y1 > 0) ? integral[(y1 - 1) * image.width + x2] : 0;
-			uint32_t C = (x1 > 0) ? integral[y2 * image.width + (x1 - 1)] : 0;
-			uint32_t D = (y1 > 0 && x1 > 0) ? integral[(y1 - 1) * image.width + (x1 - 1)] : 0;
-
-			float local_mean = static_cast<float>(A - B - C + D) / count;
-			float pixel_val  = static_cast<float>(image.pixels[j * image.width + i]);
-
-			output_image.pixels[j * image.width + i] = (pixel_val < t * local_mean) ? 0 : 255;
-		}
+			threshold_sliding<decltype(half)::value>(image, output_image, half_window, t);
+		};
+		dispatch_half_window(half_window, kernel);
+		return output_image;
 	}
 
+	// tile-relative integral image, exact for any image size with 32 bits per entry
+	const TiledIntegralImage integral = TiledIntegralImage::build(image, [](uint8_t v) { return v; });
+	auto kernel = [&](auto half)
+	{
+		threshold_integral<decltype(half)::value>(image, integral, output_image, half_window, t);
+	};
+	dispatch_half_window(half_window, kernel);
+
 	return output_image;
 }
 
+BinaryImage IntegralImageProcessor::apply_approximate(const GSImage& image, WindowEngine engine, int window_size,
+                                                     float t, int grid_factor)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return BinaryImage();
+	if (!ThresholdSurface::is_valid_factor(grid_factor)) return BinaryImage();
+	// every pixel is a grid point, the exact pass skips the surface
+	if (grid_factor == 1) return apply_binary(image, engine, window_size, t);
+
+	const int half_window = window_size / 2;
+	ThresholdSurface surface(image.width, image.height, grid_factor);
+
+	if (engine == WindowEngine::SLIDING_WINDOW)
+	{
+		auto sample = [&](int i, int j, uint32_t sum, uint64_t, uint32_t count)
+		{
+			surface.at(i, j) = t * (static_cast<float>(sum) / count);
+		};
+		auto kernel = [&](auto half)
+		{
+			surface.for_each_sample<decltype(half)::value>(image, half_window, false, sample);
+		};
+		dispatch_half_window(half_window, kernel);
+		return surface.binarize(image);
+	}
+
+	const TiledIntegralImage integral = TiledIntegralImage::build(image, [](uint8_t v) { return v; });
+	const int width                   = image.width;
+	const int height                  = image.height;
+	auto sample                       = [&](int i, int j, int x, int y)
+	{
+		const int x1         = std::max(0, x - half_window);
+		const int x2         = std::min(width - 1, x + half_window);
+		const int y1         = std::max(0, y - half_window);
+		const int y2         = std::min(height - 1, y + half_window);
+		const uint32_t count = static_cast<uint32_t>((x2 - x1 + 1) * (y2 - y1 + 1));
+		surface.at(i, j)     = t * (static_cast<float>(integral.box_sum(x1, y1, x2, y2)) / count);
+	};
+	surface.for_each_point(sample);
+	return surface.binarize(image);
+}
+
+BinaryImage IntegralImageProcessor::apply_rgb(const PPMImage& image, int window_size, float t)
+{
+	return FusedThreshold::apply_mean(image, window_size, below_mean(t));
+}
+
+ThresholdStream IntegralImageProcessor::stream(int width, int window_size, float t)
+{
+	auto threshold_row = [width, rule = below_mean(t)](const uint8_t* pixels, const uint32_t* sums, const uint64_t*,
+	                                                   const uint32_t* counts, uint64_t* out)
+	{
+		auto is_ink = [&](int i) { return rule(static_cast<float>(pixels[i]), sums[i], counts[i]); };
+		BinaryImage::pack_row(out, width, is_ink);
+	};
+	return ThresholdStream(width, window_size, false, threshold_row);
+}
+
 } // namespace processors
 } // namespace imgclean
@@ -0,0 +1,17 @@
+#include "imgclean/processors/LocalStatistics.hpp"
+
+namespace imgclean::processors
+{
+
+LocalStatistics LocalStatistics::compute(const GSImage& image)
+{
+	LocalStatistics stats;
+	if (image.empty()) return stats;
+
+	stats.sum    = TiledIntegralImage::build(image, [](uint8_t v) { return static_cast<uint64_t>(v); });
+	stats.sum_sq = TiledIntegralImage::build(image, [](uint8_t v) { return static_cast<uint64_t>(v) * v; });
+
+	return stats;
+}
+
+} // namespace imgclean::processors
@@ -0,0 +1,266 @@
+#include "imgclean/processors/MedianProcessor.hpp"
+
+#include "imgclean/processors/WindowKernel.hpp"
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__)
+# include <immintrin.h>
+#endif
+
+namespace imgclean::processors
+{
+namespace
+{
+//! Bins of a fine histogram, of a coarse histogram, and fine bins per coarse bin
+constexpr int fine_bins    = 256;
+constexpr int coarse_bins  = 16;
+constexpr int segment_bins = 16;
+
+//! dst += add - sub on one histogram segment, the counters wrap but the result is in range
+inline void add_sub(uint16_t* dst, const uint16_t* add, const uint16_t* sub)
+{
+#if defined(__AVX2__)
+	const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(add));
+	const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sub));
+	__m256i d       = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst));
+	d               = _mm256_sub_epi16(_mm256_add_epi16(d, a), s);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), d);
+#elif defined(__SSE2__)
+	for (int k = 0; k < segment_bins; k += 8)
+	{
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(add + k));
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub + k));
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + k));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + k), _mm_sub_epi16(_mm_add_epi16(d, a), s));
+	}
+#else
+	for (int k = 0; k < segment_bins; ++k)
+	{
+		dst[k] = static_cast<uint16_t>(dst[k] + add[k] - sub[k]);
+	}
+#endif
+}
+
+//! dst += add on one histogram segment
+inline void add(uint16_t* dst, const uint16_t* src)
+{
+	for (int k = 0; k < segment_bins; ++k)
+	{
+		dst[k] = static_cast<uint16_t>(dst[k] + src[k]);
+	}
+}
+
+//! Histograms of the columns of one strip, including the window_size - 1 halo columns
+struct ColumnHistograms
+{
+	std::vector<uint16_t> fine;
+	std::vector<uint16_t> coarse;
+	//! Image column of every strip column, clamped to the image
+	std::vector<int> source;
+
+	uint16_t* fine_segment(int column, int segment)
+	{
+		return fine.data() + static_cast<size_t>(column) * fine_bins + segment * segment_bins;
+	}
+	uint16_t* coarse_histogram(int column) { return coarse.data() + static_cast<size_t>(column) * coarse_bins; }
+
+	void count(int column, uint8_t value, int delta)
+	{
+		fine[static_cast<size_t>(column) * fine_bins + value] += delta;
+		coarse[static_cast<size_t>(column) * coarse_bins + value / segment_bins] += delta;
+	}
+};
+
+//! Median of three values
+inline uint8_t median3(uint8_t a, uint8_t b, uint8_t c)
+{
+	return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+//! 3x3 median of one row from the sorted columns: the median of the largest low, the median middle and the
+//! smallest high value. Branch-free min/max, so the loop vectorizes.
+void median3x3_row(const uint8_t* above, const uint8_t* center, const uint8_t* below, uint8_t* out, int width,
+                   std::vector<uint8_t>& lo, std::vector<uint8_t>& mid, std::vector<uint8_t>& hi)
+{
+	for (int x = 0; x < width; ++x)
+	{
+		const uint8_t a = above[x];
+		const uint8_t b = center[x];
+		const uint8_t c = below[x];
+		lo[x + 1]       = std::min(std::min(a, b), c);
+		hi[x + 1]       = std::max(std::max(a, b), c);
+		mid[x + 1]      = median3(a, b, c);
+	}
+	// columns -1 and width replicate the border columns
+	for (std::vector<uint8_t>* column : {&lo, &mid, &hi})
+	{
+		(*column)[0]         = (*column)[1];
+		(*column)[width + 1] = (*column)[width];
+	}
+	for (int x = 0; x < width; ++x)
+	{
+		const uint8_t max_lo = std::max(std::max(lo[x], lo[x + 1]), lo[x + 2]);
+		const uint8_t min_hi = std::min(std::min(hi[x], hi[x + 1]), hi[x + 2]);
+		out[x]               = median3(max_lo, median3(mid[x], mid[x + 1], mid[x + 2]), min_hi);
+	}
+}
+
+//! Filters the output columns [x_begin, x_end) of all rows
+void median_strip(const GSImage& image, GSImage& output_image, int x_begin, int x_end, int half_window,
+                  ColumnHistograms& columns)
+{
+	const int width       = image.width;
+	const int height      = image.height;
+	const int window_size = 2 * half_window + 1;
+	const int lanes       = x_end - x_begin;
+	const int num_columns = lanes + 2 * half_window;
+	// 0-based rank of the median among the window_size^2 pixels
+	const uint32_t rank = static_cast<uint32_t>(window_size * window_size) / 2;
+
+	columns.fine.assign(static_cast<size_t>(num_columns) * fine_bins, 0);
+	columns.coarse.assign(static_cast<size_t>(num_columns) * coarse_bins, 0);
+	columns.source.resize(num_columns);
+	for (int c = 0; c < num_columns; ++c)
+	{
+		columns.source[c] = std::clamp(x_begin - half_window + c, 0, width - 1);
+	}
+	auto image_row = [&](int y)
+	{
+		return image.pixels.data() + static_cast<size_t>(std::clamp(y, 0, height - 1)) * width;
+	};
+
+	// column windows of row 0
+	for (int y = -half_window; y <= half_window; ++y)
+	{
+		const uint8_t* pixels = image_row(y);
+		for (int c = 0; c < num_columns; ++c)
+		{
+			columns.count(c, pixels[columns.source[c]], 1);
+		}
+	}
+
+	uint16_t kernel_coarse[coarse_bins];
+	uint16_t kernel_fine[fine_bins];
+	// output column at which a fine segment of the window was last brought up to date
+	int updated[coarse_bins];
+
+	for (int y = 0; y < height; ++y)
+	{
+		if (y > 0)
+		{
+			const uint8_t* removed = image_row(y - half_window - 1);
+			const uint8_t* added   = image_row(y + half_window);
+			for (int c = 0; c < num_columns; ++c)
+			{
+				const uint8_t old_value = removed[columns.source[c]];
+				const uint8_t new_value = added[columns.source[c]];
+				if (old_value == new_value) continue;
+				columns.count(c, old_value, -1);
+				columns.count(c, new_value, 1);
+			}
+		}
+
+		std::fill(std::begin(kernel_coarse), std::end(kernel_coarse), 0);
+		for (int c = 0; c < window_size; ++c)
+		{
+			add(kernel_coarse, columns.coarse_histogram(c));
+		}
+		std::fill(std::begin(updated), std::end(updated), -1);
+
+		uint8_t* out = output_image.pixels.data() + static_cast<size_t>(y) * width + x_begin;
+		for (int i = 0; i < lanes; ++i)
+		{
+			if (i > 0)
+			{
+				add_sub(kernel_coarse, columns.coarse_histogram(i + window_size - 1),
+				        columns.coarse_histogram(i - 1));
+			}
+
+			int segment    = 0;
+			uint32_t below = 0;
+			while (below + kernel_coarse[segment] <= rank)
+			{
+				below += kernel_coarse[segment++];
+			}
+
+			// bring the fine segment to column i, rebuild it if that is cheaper than sliding
+			uint16_t* fine = kernel_fine + segment * segment_bins;
+			if (updated[segment] < 0 || i - updated[segment] > window_size)
+			{
+				std::fill(fine, fine + segment_bins, 0);
+				for (int c = i; c < i + window_size; ++c)
+				{
+					add(fine, columns.fine_segment(c, segment));
+				}
+			}
+			else
+			{
+				for (int j = updated[segment] + 1; j <= i; ++j)
+				{
+					add_sub(fine, columns.fine_segment(j + window_size - 1, segment),
+					        columns.fine_segment(j - 1, segment));
+				}
+			}
+			updated[segment] = i;
+
+			int bin = 0;
+			while (below + fine[bin] <= rank)
+			{
+				below += fine[bin++];
+			}
+			out[i] = static_cast<uint8_t>(segment * segment_bins + bin);
+		}
+	}
+}
+} // namespace
+
+GSImage MedianProcessor::apply(const GSImage& image, int window_size)
+{
+	if (image.empty() || !is_valid_window_size(window_size) || window_size > max_window_size) return GSImage();
+
+	GSImage output_image;
+	output_image.width     = image.width;
+	output_image.height    = image.height;
+	output_image.maxval    = image.maxval;
+	output_image.exif_data = image.exif_data;
+	output_image.pixels.resize(image.pixel_count());
+
+	const int width  = image.width;
+	const int height = image.height;
+	if (window_size == 3)
+	{
+		// a 3x3 median is cheaper as a min/max network than with histograms
+#pragma omp parallel
+		{
+			std::vector<uint8_t> lo(width + 2), mid(width + 2), hi(width + 2);
+#pragma omp for schedule(static)
+			for (int y = 0; y < height; ++y)
+			{
+				auto row     = [&](int v) { return image.pixels.data() + static_cast<size_t>(v) * width; };
+				uint8_t* out = output_image.pixels.data() + static_cast<size_t>(y) * width;
+				median3x3_row(row(std::max(0, y - 1)), row(y), row(std::min(height - 1, y + 1)), out, width, lo,
+				              mid, hi);
+			}
+		}
+		return output_image;
+	}
+
+	// wide windows get wider strips, so the halo columns stay a small share of the work
+	const int strip_width = std::max(strip_columns, 2 * window_size);
+	const int num_strips  = (image.width + strip_width - 1) / strip_width;
+#pragma omp parallel
+	{
+		ColumnHistograms columns;
+#pragma omp for schedule(static)
+		for (int s = 0; s < num_strips; ++s)
+		{
+			const int x_begin = s * strip_width;
+			const int x_end   = std::min(image.width, x_begin + strip_width);
+			median_strip(image, output_image, x_begin, x_end, window_size / 2, columns);
+		}
+	}
+
+	return output_image;
+}
+} // namespace imgclean::processors
@@ -0,0 +1,41 @@
+#include "imgclean/processors/NiblackProcessor.hpp"
+#include "imgclean/processors/FusedThreshold.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/LocalThreshold.hpp"
+
+namespace imgclean::processors
+{
+namespace
+{
+//! T = m + k * s
+auto niblack_rule(float k)
+{
+	return [k](float pixel, float mean, float stddev) { return pixel < mean + k * stddev; };
+}
+} // namespace
+
+GSImage NiblackProcessor::apply(const GSImage& image, WindowEngine engine, int window_size, float k)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return GSImage();
+
+	GSImage output_image = HelperProcessor::binary_to_grayscale(apply_binary(image, engine, window_size, k));
+	output_image.maxval  = image.maxval;
+	return output_image;
+}
+
+BinaryImage NiblackProcessor::apply_binary(const GSImage& image, WindowEngine engine, int window_size, float k)
+{
+	return threshold_local(image, engine, window_size, niblack_rule(k));
+}
+
+BinaryImage NiblackProcessor::apply_rgb(const PPMImage& image, int window_size, float k)
+{
+	return FusedThreshold::apply_local(image, window_size, niblack_rule(k));
+}
+
+ThresholdStream NiblackProcessor::stream(int width, int window_size, float k)
+{
+	return stream_local(width, window_size, niblack_rule(k));
+}
+
+} // namespace imgclean::processors
@@ -0,0 +1,203 @@
+#include "imgclean/processors/OtsuProcessor.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+# include <immintrin.h>
+#endif
+
+namespace imgclean::processors
+{
+namespace
+{
+//! Number of interleaved sub-histograms. Consecutive pixels go to different tables,
+//! so runs of equal values (the common case on paper) do not serialize on one counter.
+constexpr int num_sub_histograms = 4;
+
+//! Counts n pixels into the sub-histograms, 8 pixels per 64-bit load
+void count_pixels(const uint8_t* pixels, size_t n, uint32_t (&sub)[num_sub_histograms][256])
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, pixels + i, sizeof(word));
+		++sub[0][word & 0xff];
+		++sub[1][(word >> 8) & 0xff];
+		++sub[2][(word >> 16) & 0xff];
+		++sub[3][(word >> 24) & 0xff];
+		++sub[0][(word >> 32) & 0xff];
+		++sub[1][(word >> 40) & 0xff];
+		++sub[2][(word >> 48) & 0xff];
+		++sub[3][word >> 56];
+	}
+	for (; i < n; ++i)
+	{
+		++sub[0][pixels[i]];
+	}
+}
+
+//! Packs one row: bit x is set iff pixels[x] < threshold, 1 <= threshold <= 255
+void pack_below(const uint8_t* pixels, uint64_t* dst, int width, uint8_t threshold)
+{
+	int x = 0;
+#if defined(__AVX2__)
+	// pixel < threshold <=> min(pixel, threshold - 1) == pixel
+	const __m256i limit = _mm256_set1_epi8(static_cast<char>(threshold - 1));
+	for (; x + 64 <= width; x += 64)
+	{
+		const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + x));
+		const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + x + 32));
+		const uint32_t mask_lo =
+			static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(lo, limit), lo)));
+		const uint32_t mask_hi =
+			static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(hi, limit), hi)));
+		dst[x / 64] = static_cast<uint64_t>(mask_hi) << 32 | mask_lo;
+	}
+#elif defined(__SSE2__)
+	const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold - 1));
+	for (; x + 64 <= width; x += 64)
+	{
+		uint64_t word = 0;
+		for (int k = 0; k < 4; ++k)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x + 16 * k));
+			const uint32_t mask =
+				static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, limit), v)));
+			word |= static_cast<uint64_t>(mask) << (16 * k);
+		}
+		dst[x / 64] = word;
+	}
+#endif
+	// scalar fallback and the last partial word
+	if (x < width)
+	{
+		BinaryImage::pack_row(dst + x / 64, width - x, [&](int i) { return pixels[x + i] < threshold; });
+	}
+}
+} // namespace
+
+OtsuProcessor::Histogram OtsuProcessor::histogram(const GSImage& image)
+{
+	Histogram hist{};
+	const size_t num_pixels = image.pixels.size();
+	const size_t num_chunks = (num_pixels + chunk_pixels - 1) / chunk_pixels;
+	const uint8_t* pixels   = image.pixels.data();
+
+#pragma omp parallel
+	{
+		Histogram local{};
+		uint32_t sub[num_sub_histograms][256];
+
+#pragma omp for schedule(static)
+		for (size_t c = 0; c < num_chunks; ++c)
+		{
+			const size_t begin = c * chunk_pixels;
+			std::memset(sub, 0, sizeof(sub));
+			count_pixels(pixels + begin, std::min(chunk_pixels, num_pixels - begin), sub);
+			for (int v = 0; v < 256; ++v)
+			{
+				local[v] += uint64_t(sub[0][v]) + sub[1][v] + sub[2][v] + sub[3][v];
+			}
+		}
+
+		// integer counts -> the merge order does not matter
+#pragma omp critical
+		for (int v = 0; v < 256; ++v)
+		{
+			hist[v] += local[v];
+		}
+	}
+
+	return hist;
+}
+
+int OtsuProcessor::threshold(const Histogram& hist)
+{
+	uint64_t total = 0;
+	double sum     = 0.0;
+	for (int v = 0; v < 256; ++v)
+	{
+		total += hist[v];
+		sum += static_cast<double>(v) * hist[v];
+	}
+
+	// between-class variance w_b * w_f * (m_b - m_f)^2 for the dark class [0, t] and the bright class (t, 255]
+	int best_t          = -1;
+	double best_between = 0.0;
+	uint64_t weight_b   = 0;
+	double sum_b        = 0.0;
+	for (int t = 0; t < 255; ++t)
+	{
+		weight_b += hist[t];
+		sum_b += static_cast<double>(t) * hist[t];
+		const uint64_t weight_f = total - weight_b;
+		if (weight_b == 0) continue;
+		if (weight_f == 0) break;
+
+		const double mean_b  = sum_b / static_cast<double>(weight_b);
+		const double mean_f  = (sum - sum_b) / static_cast<double>(weight_f);
+		const double between = static_cast<double>(weight_b) * static_cast<double>(weight_f) *
+		                       (mean_b - mean_f) * (mean_b - mean_f);
+		if (between > best_between)
+		{
+			best_between = between;
+			best_t       = t;
+		}
+	}
+
+	return best_t + 1;
+}
+
+GSImage OtsuProcessor::apply(const GSImage& image)
+{
+	if (image.empty()) return GSImage();
+
+	const uint8_t threshold_value = static_cast<uint8_t>(threshold(histogram(image)));
+	const size_t num_pixels       = image.pixels.size();
+	const uint8_t* pixels         = image.pixels.data();
+
+	GSImage output_image;
+	output_image.width     = image.width;
+	output_image.height    = image.height;
+	output_image.maxval    = image.maxval;
+	output_image.exif_data = image.exif_data;
+	output_image.pixels.resize(num_pixels);
+	uint8_t* out = output_image.pixels.data();
+
+	// single compare pass, vectorized by the compiler
+#pragma omp parallel for simd schedule(static)
+	for (size_t i = 0; i < num_pixels; ++i)
+	{
+		out[i] = pixels[i] < threshold_value ? 0 : 255;
+	}
+
+	return output_image;
+}
+
+BinaryImage OtsuProcessor::apply_binary(const GSImage& image)
+{
+	if (image.empty()) return BinaryImage();
+
+	const int threshold_value = threshold(histogram(image));
+	const int width           = image.width;
+	const int height          = image.height;
+
+	BinaryImage output_image;
+	output_image.resize(width, height);
+	output_image.exif_data = image.exif_data;
+	// threshold 0 -> no ink, the words are already cleared
+	if (threshold_value == 0) return output_image;
+
+#pragma omp parallel for schedule(static)
+	for (int y = 0; y < height; ++y)
+	{
+		pack_below(image.pixels.data() + static_cast<size_t>(y) * width, output_image.row(y), width,
+		           static_cast<uint8_t>(threshold_value));
+	}
+
+	return output_image;
+}
+
+} // namespace imgclean::processors
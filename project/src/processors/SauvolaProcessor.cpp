@@ -0,0 +1,44 @@
+#include "imgclean/processors/SauvolaProcessor.hpp"
+#include "imgclean/processors/FusedThreshold.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/LocalThreshold.hpp"
+
+namespace imgclean::processors
+{
+namespace
+{
+//! T = m * (1 + k * (s / R - 1))
+auto sauvola_rule(float k)
+{
+	return [k](float pixel, float mean, float stddev)
+	{
+		return pixel < mean * (1.0f + k * (stddev / SauvolaProcessor::r - 1.0f));
+	};
+}
+} // namespace
+
+GSImage SauvolaProcessor::apply(const GSImage& image, WindowEngine engine, int window_size, float k)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return GSImage();
+
+	GSImage output_image = HelperProcessor::binary_to_grayscale(apply_binary(image, engine, window_size, k));
+	output_image.maxval  = image.maxval;
+	return output_image;
+}
+
+BinaryImage SauvolaProcessor::apply_binary(const GSImage& image, WindowEngine engine, int window_size, float k)
+{
+	return threshold_local(image, engine, window_size, sauvola_rule(k));
+}
+
+BinaryImage SauvolaProcessor::apply_rgb(const PPMImage& image, int window_size, float k)
+{
+	return FusedThreshold::apply_local(image, window_size, sauvola_rule(k));
+}
+
+ThresholdStream SauvolaProcessor::stream(int width, int window_size, float k)
+{
+	return stream_local(width, window_size, sauvola_rule(k));
+}
+
+} // namespace imgclean::processors
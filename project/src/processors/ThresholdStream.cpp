@@ -0,0 +1,71 @@
+#include "imgclean/processors/ThresholdStream.hpp"
+
+#include "imgclean/BinaryImage.hpp"
+#include "imgclean/processors/WindowKernel.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace imgclean::processors
+{
+
+ThresholdStream::ThresholdStream(int width, int window_size, bool squares, RowRule rule)
+{
+	if (width <= 0 || !is_valid_window_size(window_size) || rule == nullptr) return;
+
+	row_width   = width;
+	half_window = window_size / 2;
+	ring_rows   = 2 * half_window + 2;
+	engine      = BoxSumEngine(width, half_window, squares);
+	this->rule  = std::move(rule);
+	ring.resize(static_cast<size_t>(ring_rows) * width);
+	sums.resize(width);
+	sums_sq.resize(squares ? width : 0);
+	counts.resize(width);
+	packed.resize(BinaryImage::row_words(width));
+}
+
+void ThresholdStream::push_row(const uint8_t* row, const RowSink& sink)
+{
+	if (empty()) return;
+
+	// the slot of row rows_in held row rows_in - ring_rows, which left the window two rows ago
+	uint8_t* slot = ring_row(rows_in);
+	std::memcpy(slot, row, static_cast<size_t>(row_width));
+	engine.add_row(slot);
+	++rows_in;
+
+	// the window of row y ends at y + half_window, which has just been added
+	const int y = rows_in - 1 - half_window;
+	if (y >= 0) emit(y, sink);
+}
+
+void ThresholdStream::finish(const RowSink& sink)
+{
+	if (empty()) return;
+
+	// the windows of the last rows are clipped at the bottom of the page, no rows are added any more
+	for (int y = std::max(0, rows_in - half_window); y < rows_in; ++y)
+	{
+		emit(y, sink);
+	}
+	engine.reset();
+	rows_in = 0;
+}
+
+void ThresholdStream::emit(int y, const RowSink& sink)
+{
+	if (y - half_window - 1 >= 0) engine.remove_row(ring_row(y - half_window - 1));
+
+	uint64_t* sums_sq_ptr = sums_sq.empty() ? nullptr : sums_sq.data();
+	auto kernel           = [&](auto half)
+	{
+		engine.row_sums<decltype(half)::value>(sums.data(), sums_sq_ptr, counts.data());
+	};
+	dispatch_half_window(half_window, kernel);
+
+	rule(ring_row(y), sums.data(), sums_sq_ptr, counts.data(), packed.data());
+	sink(y, packed.data());
+}
+
+} // namespace imgclean::processors
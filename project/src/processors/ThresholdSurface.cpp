@@ -0,0 +1,77 @@
+#include "imgclean/processors/ThresholdSurface.hpp"
+
+namespace imgclean::processors
+{
+namespace
+{
+//! Number of grid positions covering [0, size - 1] with the given step, the last one is size - 1
+int grid_size(int size, int factor) { return size <= 1 ? 1 : (size - 2) / factor + 2; }
+} // namespace
+
+ThresholdSurface::ThresholdSurface(int width, int height, int factor)
+	: width(width)
+	, height(height)
+	, grid_factor(factor)
+	, grid_columns(grid_size(width, factor))
+	, grid_rows(grid_size(height, factor))
+	, values(static_cast<size_t>(grid_columns) * grid_rows, 0.0f)
+{
+}
+
+BinaryImage ThresholdSurface::binarize(const GSImage& image) const
+{
+	BinaryImage output_image;
+	output_image.resize(image.width, image.height);
+	output_image.exif_data = image.exif_data;
+
+	// left grid column and horizontal weight of every pixel column
+	std::vector<int> column(width);
+	std::vector<float> weight(width);
+	for (int col = 0; col < width; ++col)
+	{
+		const int i  = std::min(col / grid_factor, grid_columns - 1);
+		const int x0 = x(i);
+		const int x1 = x(std::min(i + 1, grid_columns - 1));
+		column[col]  = i;
+		weight[col]  = x1 > x0 ? static_cast<float>(col - x0) / static_cast<float>(x1 - x0) : 0.0f;
+	}
+
+#pragma omp parallel
+	{
+		// thresholds of the current pixel row at the grid columns, one extra entry for the right border
+		std::vector<float> row_values(grid_columns + 1);
+
+#pragma omp for schedule(static)
+		for (int row = 0; row < height; ++row)
+		{
+			const int j  = std::min(row / grid_factor, grid_rows - 1);
+			const int j1 = std::min(j + 1, grid_rows - 1);
+			const int y0 = y(j);
+			const int y1 = y(j1);
+			const float wy =
+				y1 > y0 ? static_cast<float>(row - y0) / static_cast<float>(y1 - y0) : 0.0f;
+
+			const float* top    = values.data() + static_cast<size_t>(j) * grid_columns;
+			const float* bottom = values.data() + static_cast<size_t>(j1) * grid_columns;
+			for (int i = 0; i < grid_columns; ++i)
+			{
+				row_values[i] = top[i] + wy * (bottom[i] - top[i]);
+			}
+			row_values[grid_columns] = row_values[grid_columns - 1];
+
+			const uint8_t* pixels = image.pixels.data() + static_cast<size_t>(row) * width;
+			auto is_ink           = [&](int col)
+			{
+				const float left      = row_values[column[col]];
+				const float right     = row_values[column[col] + 1];
+				const float threshold = left + weight[col] * (right - left);
+				return pixels[col] < threshold;
+			};
+			BinaryImage::pack_row(output_image.row(row), width, is_ink);
+		}
+	}
+
+	return output_image;
+}
+
+} // namespace imgclean::processors
@@ -0,0 +1,55 @@
+#include "imgclean/processors/WolfProcessor.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/LocalThreshold.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace imgclean::processors
+{
+
+GSImage WolfProcessor::apply(const GSImage& image, WindowEngine engine, int window_size, float k)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return GSImage();
+
+	GSImage output_image = HelperProcessor::binary_to_grayscale(apply_binary(image, engine, window_size, k));
+	output_image.maxval  = image.maxval;
+	return output_image;
+}
+
+BinaryImage WolfProcessor::apply_binary(const GSImage& image, WindowEngine engine, int window_size, float k)
+{
+	if (image.empty() || !is_valid_window_size(window_size)) return BinaryImage();
+
+	const LocalStatisticsEngine windows(image, engine, window_size);
+
+	// first pass: largest local stddev, per row so that the result does not depend on the number of threads
+	std::vector<float> row_max_stddev(image.height, 0.0f);
+	auto max_row = [&](int y, const auto& row)
+	{
+		float row_max = 0.0f;
+		for (int x = 0; x < image.width; ++x)
+		{
+			float mean   = 0.0f;
+			float stddev = 0.0f;
+			row.stats(x, mean, stddev);
+			row_max = std::max(row_max, stddev);
+		}
+		row_max_stddev[y] = row_max;
+	};
+	windows.for_each_row(max_row);
+
+	const float max_stddev = *std::max_element(row_max_stddev.begin(), row_max_stddev.end());
+	const float min_gray   = static_cast<float>(*std::min_element(image.pixels.begin(), image.pixels.end()));
+	// a flat image has no contrast, s / R is then taken as 0
+	const float inv_max_stddev = max_stddev > 0.0f ? 1.0f / max_stddev : 0.0f;
+
+	// second pass: threshold
+	auto is_ink = [=](float pixel, float mean, float stddev)
+	{
+		return pixel < mean - k * (1.0f - stddev * inv_max_stddev) * (mean - min_gray);
+	};
+	return threshold_local(windows, is_ink);
+}
+
+} // namespace imgclean::processors
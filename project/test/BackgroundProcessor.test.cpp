@@ -0,0 +1,91 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/BackgroundProcessor.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+using imgclean::processors::BackgroundProcessor;
+
+//! Brute force maximum over the clipped window around every pixel
+static imgclean::GSImage brute_force_max(const imgclean::GSImage& image, int window_size)
+{
+	const int half                = window_size / 2;
+	imgclean::GSImage output_image = image;
+	for (int y = 0; y < image.height; ++y)
+	{
+		for (int x = 0; x < image.width; ++x)
+		{
+			uint8_t value = 0;
+			for (int v = std::max(0, y - half); v <= std::min(image.height - 1, y + half); ++v)
+			{
+				for (int u = std::max(0, x - half); u <= std::min(image.width - 1, x + half); ++u)
+				{
+					value = std::max(value, image.pixels[v * image.width + u]);
+				}
+			}
+			output_image.pixels[y * image.width + x] = value;
+		}
+	}
+	return output_image;
+}
+
+//! Inverts the gray values, turns a max filter into a min filter
+static imgclean::GSImage invert(imgclean::GSImage image)
+{
+	for (uint8_t& value : image.pixels)
+	{
+		value = static_cast<uint8_t>(255 - value);
+	}
+	return image;
+}
+
+TEST_CASE("van Herk/Gil-Werman filters match brute force", "[BackgroundProcessor]")
+{
+	// windows smaller, close to and larger than the image, several column strips
+	const imgclean::GSImage image = make_document_image(300, 37, 3);
+	for (int window : {1, 3, 7, 21, 37, 75, 401})
+	{
+		INFO("window " << window);
+		const imgclean::GSImage expected = brute_force_max(image, window);
+		REQUIRE(BackgroundProcessor::max_filter(image, window).pixels == expected.pixels);
+		REQUIRE(BackgroundProcessor::min_filter(invert(image), window).pixels == invert(expected).pixels);
+	}
+
+	REQUIRE(BackgroundProcessor::max_filter(image, 4).empty());
+	REQUIRE(BackgroundProcessor::apply(imgclean::GSImage()).empty());
+}
+
+TEST_CASE("Background normalization flattens shading", "[BackgroundProcessor]")
+{
+	// strong left-to-right gradient under the text
+	imgclean::GSImage image = make_document_image(200, 120, 9);
+	for (int y = 0; y < image.height; ++y)
+	{
+		for (int x = 0; x < image.width; ++x)
+		{
+			uint8_t& value = image.pixels[y * image.width + x];
+			value          = static_cast<uint8_t>(value * (100 + x / 2) / 200);
+		}
+	}
+
+	const imgclean::GSImage background = BackgroundProcessor::estimate(image, 31);
+	const imgclean::GSImage normalized = BackgroundProcessor::apply(image, 31);
+
+	// the closing lies on or above the image and the background becomes bright on both sides
+	for (size_t i = 0; i < image.pixels.size(); ++i)
+	{
+		REQUIRE(background.pixels[i] >= image.pixels[i]);
+	}
+	auto column_mean = [&](const imgclean::GSImage& img, int x)
+	{
+		int sum = 0;
+		for (int y = 0; y < img.height; ++y)
+		{
+			sum += img.pixels[y * img.width + x];
+		}
+		return sum / img.height;
+	};
+	REQUIRE(column_mean(image, 195) - column_mean(image, 5) > 100);
+	REQUIRE(std::abs(column_mean(normalized, 195) - column_mean(normalized, 5)) < 25);
+}
@@ -0,0 +1,168 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/BinaryImage.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/ImageBinarizationProcessor.hpp"
+#include "imgclean/processors/IntegralImageProcessor.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <vector>
+
+using imgclean::BinaryImage;
+using imgclean::processors::HelperProcessor;
+
+TEST_CASE("BinaryImage packs rows LSB first into 64-bit words", "[BinaryImage]")
+{
+	BinaryImage image;
+	image.resize(70, 3);
+	REQUIRE(image.words_per_row == 2);
+	REQUIRE(image.words.size() == 6);
+
+	image.set(0, 0, true);
+	image.set(63, 0, true);
+	image.set(64, 1, true);
+	image.set(69, 2, true);
+	REQUIRE(image.row(0)[0] == ((uint64_t(1) << 63) | 1u));
+	REQUIRE(image.row(0)[1] == 0);
+	REQUIRE(image.row(1)[1] == 1u);
+	REQUIRE(image.row(2)[1] == (uint64_t(1) << 5));
+	REQUIRE(image.get(69, 2));
+	REQUIRE_FALSE(image.get(68, 2));
+
+	image.set(63, 0, false);
+	REQUIRE(image.row(0)[0] == 1u);
+}
+
+TEST_CASE("BinaryImage conversions round trip", "[BinaryImage]")
+{
+	const imgclean::GSImage gray = make_document_image(130, 17, 4);
+	const BinaryImage binary     = HelperProcessor::grayscale_to_binary(gray);
+	REQUIRE(binary.width == gray.width);
+	REQUIRE(binary.height == gray.height);
+
+	bool all_equal = true;
+	for (int y = 0; y < gray.height; ++y)
+	{
+		for (int x = 0; x < gray.width; ++x)
+		{
+			all_equal &= binary.get(x, y) == (gray.pixels[y * gray.width + x] < 128);
+		}
+		// padding bits past the last pixel stay zero
+		all_equal &= (binary.row(y)[2] >> 2) == 0;
+	}
+	REQUIRE(all_equal);
+
+	const imgclean::GSImage expanded = HelperProcessor::binary_to_grayscale(binary);
+	REQUIRE(expanded.width == gray.width);
+	REQUIRE(expanded.height == gray.height);
+	for (size_t i = 0; i < gray.pixels.size(); ++i)
+	{
+		all_equal &= expanded.pixels[i] == (gray.pixels[i] < 128 ? 0 : 255);
+	}
+	REQUIRE(all_equal);
+	REQUIRE(HelperProcessor::grayscale_to_binary(expanded).words == binary.words);
+}
+
+//! Naive reference of IntegralImageProcessor: every window is summed pixel by pixel
+static BinaryImage mean_threshold_naive(const imgclean::GSImage& image, int half_window, float t)
+{
+	BinaryImage out;
+	out.resize(image.width, image.height);
+	for (int y = 0; y < image.height; ++y)
+	{
+		for (int x = 0; x < image.width; ++x)
+		{
+			const int x1 = std::max(0, x - half_window), x2 = std::min(image.width - 1, x + half_window);
+			const int y1 = std::max(0, y - half_window), y2 = std::min(image.height - 1, y + half_window);
+			uint32_t sum = 0;
+			for (int v = y1; v <= y2; ++v)
+			{
+				for (int u = x1; u <= x2; ++u) sum += image.pixels[v * image.width + u];
+			}
+			const float mean = static_cast<float>(sum) / ((x2 - x1 + 1) * (y2 - y1 + 1));
+			out.set(x, y, image.pixels[y * image.width + x] < t * mean);
+		}
+	}
+	return out;
+}
+
+//! Naive reference of ImageBinarizationProcessor: window statistics summed pixel by pixel in double
+static BinaryImage adaptive_naive(const imgclean::GSImage& image, int half_window)
+{
+	const size_t num_pixels = image.pixels.size();
+	std::vector<double> mean(num_pixels), stddev(num_pixels);
+	double total = 0.0;
+	for (int y = 0; y < image.height; ++y)
+	{
+		for (int x = 0; x < image.width; ++x)
+		{
+			const int x1 = std::max(0, x - half_window), x2 = std::min(image.width - 1, x + half_window);
+			const int y1 = std::max(0, y - half_window), y2 = std::min(image.height - 1, y + half_window);
+			double sum = 0.0, sum_sq = 0.0;
+			for (int v = y1; v <= y2; ++v)
+			{
+				for (int u = x1; u <= x2; ++u)
+				{
+					const double value = image.pixels[v * image.width + u];
+					sum += value;
+					sum_sq += value * value;
+				}
+			}
+			const double count = (x2 - x1 + 1) * (y2 - y1 + 1);
+			const size_t index = static_cast<size_t>(y) * image.width + x;
+			mean[index]        = sum / count;
+			stddev[index]      = std::sqrt(std::max(0.0, sum_sq / count - mean[index] * mean[index]));
+			total += image.pixels[index];
+		}
+	}
+
+	const double global_mean = total / static_cast<double>(num_pixels);
+	const double min_stddev  = *std::min_element(stddev.begin(), stddev.end());
+	const double max_stddev  = *std::max_element(stddev.begin(), stddev.end());
+	BinaryImage out;
+	out.resize(image.width, image.height);
+	for (size_t index = 0; index < num_pixels; ++index)
+	{
+		const double s         = stddev[index];
+		const double adaptive  = max_stddev > min_stddev ? (s - min_stddev) / (max_stddev - min_stddev) : 0.0;
+		const double threshold = s - (mean[index] * mean[index] - s) / ((global_mean + s) * (adaptive + s));
+		out.set(static_cast<int>(index % image.width), static_cast<int>(index / image.width),
+		        image.pixels[index] < threshold);
+	}
+	return out;
+}
+
+//! Number of pixels that differ between two bit-packed images of the same size
+static size_t count_mismatches(const BinaryImage& a, const BinaryImage& b)
+{
+	size_t mismatches = 0;
+	for (size_t i = 0; i < a.words.size(); ++i) mismatches += std::popcount(a.words[i] ^ b.words[i]);
+	return mismatches;
+}
+
+TEST_CASE("Processors write the same result bit-packed", "[BinaryImage]")
+{
+	using imgclean::processors::ImageBinarizationProcessor;
+	using imgclean::processors::IntegralImageProcessor;
+	using imgclean::processors::WindowEngine;
+	const imgclean::GSImage image  = make_document_image(201, 150, 12);
+	const BinaryImage mean_ref     = mean_threshold_naive(image, 7, 0.85f);
+	const BinaryImage adaptive_ref = adaptive_naive(image, 7);
+
+	for (WindowEngine engine : {WindowEngine::INTEGRAL_IMAGE, WindowEngine::SLIDING_WINDOW})
+	{
+		const BinaryImage integral = IntegralImageProcessor::apply_binary(image, engine);
+		REQUIRE(integral.width == image.width);
+		REQUIRE(integral.height == image.height);
+		REQUIRE(integral.words == mean_ref.words);
+
+		// float statistics against the double reference -> allow a few flips
+		const BinaryImage adaptive = ImageBinarizationProcessor::apply_binary(image, engine);
+		REQUIRE(adaptive.words.size() == adaptive_ref.words.size());
+		REQUIRE(count_mismatches(adaptive, adaptive_ref) <= image.pixels.size() / 1000);
+	}
+
+	REQUIRE(IntegralImageProcessor::apply_binary(imgclean::GSImage()).empty());
+}
@@ -0,0 +1,48 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/BoxSumEngine.hpp"
+#include <algorithm>
+#include <vector>
+
+TEST_CASE("BoxSumEngine matches brute force window sums", "[BoxSumEngine]")
+{
+	// taller than one band, and one image narrower than the window
+	const int sizes[][3] = {
+		{41, 300, 7},
+		{5, 40, 7},
+		{64, 20, 0},
+	};
+	for (const auto& size : sizes)
+	{
+		const imgclean::GSImage image = make_document_image(size[0], size[1], 9);
+		const int half                = size[2];
+		std::vector<int> visited(image.height, 0);
+		bool all_equal = true;
+
+		imgclean::processors::BoxSumEngine::for_each_row(
+			image, half, true,
+			[&](int y, const uint32_t* sums, const uint64_t* sums_sq, const uint32_t* counts)
+			{
+				++visited[y];
+				for (int x = 0; x < image.width; ++x)
+				{
+					uint64_t s = 0, sq = 0, n = 0;
+					for (int v = std::max(0, y - half); v <= std::min(image.height - 1, y + half); ++v)
+					{
+						for (int u = std::max(0, x - half); u <= std::min(image.width - 1, x + half); ++u)
+						{
+							const uint64_t p = image.pixels[v * image.width + u];
+							s += p;
+							sq += p * p;
+							++n;
+						}
+					}
+					all_equal = all_equal && sums[x] == s && sums_sq[x] == sq && counts[x] == n;
+				}
+			});
+
+		REQUIRE(all_equal);
+		REQUIRE(std::all_of(visited.begin(), visited.end(), [](int v) { return v == 1; }));
+	}
+}
@@ -0,0 +1,160 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/ClaheProcessor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+using imgclean::processors::ClaheProcessor;
+
+TEST_CASE("Clipped tables redistribute the excess", "[ClaheProcessor]")
+{
+	// without clipping the table is the scaled cumulative histogram
+	ClaheProcessor::Histogram hist{};
+	hist[10]                         = 100;
+	hist[20]                         = 300;
+	const ClaheProcessor::Table full = ClaheProcessor::clipped_table(hist, 400, 256.0f);
+	REQUIRE(full[9] == 0);
+	REQUIRE(full[10] == 64);
+	REQUIRE(full[19] == 64);
+	REQUIRE(full[20] == 255);
+
+	// a clip limit of 1 flattens the histogram, the table becomes close to the identity,
+	// only the two clipped bins keep the limit on top of their share
+	hist[10]                         = 10000;
+	hist[20]                         = 15600;
+	const ClaheProcessor::Table flat = ClaheProcessor::clipped_table(hist, 25600, 1.0f);
+	for (int v = 0; v < 256; ++v)
+	{
+		REQUIRE(std::abs(static_cast<int>(flat[v]) - v) <= 4);
+	}
+	REQUIRE(std::is_sorted(flat.begin(), flat.end()));
+}
+
+TEST_CASE("A single tile without clipping equalizes globally", "[ClaheProcessor]")
+{
+	const imgclean::GSImage image = make_document_image(90, 70, 8);
+	ClaheProcessor::Histogram hist{};
+	for (uint8_t value : image.pixels)
+	{
+		++hist[value];
+	}
+	const auto table = ClaheProcessor::clipped_table(hist, static_cast<uint32_t>(image.pixels.size()), 256.0f);
+
+	const imgclean::GSImage output_image = ClaheProcessor::apply(image, 1, 256.0f);
+	bool all_equal                       = true;
+	for (size_t i = 0; i < image.pixels.size(); ++i)
+	{
+		all_equal &= output_image.pixels[i] == table[image.pixels[i]];
+	}
+	REQUIRE(all_equal);
+}
+
+TEST_CASE("CLAHE stretches a faded page", "[ClaheProcessor]")
+{
+	// text at 150 on paper at 200
+	imgclean::GSImage image = make_document_image(300, 200, 4);
+	for (uint8_t& value : image.pixels)
+	{
+		value = static_cast<uint8_t>(150 + value / 5);
+	}
+	const imgclean::GSImage output_image = ClaheProcessor::apply(image);
+	REQUIRE(output_image.width == image.width);
+	REQUIRE(output_image.height == image.height);
+
+	auto range = [](const imgclean::GSImage& gray)
+	{
+		const auto [min, max] = std::minmax_element(gray.pixels.begin(), gray.pixels.end());
+		return *max - *min;
+	};
+	REQUIRE(range(output_image) > range(image));
+	// the clip limit bounds the local stretch
+	REQUIRE(range(ClaheProcessor::apply(image, 8, 8.0f)) > range(output_image));
+
+	// tiny images fall back to one tile per pixel, invalid arguments give an empty image
+	REQUIRE(ClaheProcessor::apply(make_document_image(3, 2, 1), 8).pixels.size() == 6);
+	REQUIRE(ClaheProcessor::apply(image, 0).empty());
+	REQUIRE(ClaheProcessor::apply(image, 8, 0.5f).empty());
+}
+
+//! Reference CLAHE: tables from the tile histograms, float bilinear weights between the four nearest tile centers
+static imgclean::GSImage clahe_reference(const imgclean::GSImage& image, int tiles, float clip_limit)
+{
+	auto axis_tiles = [tiles](int size, int& tile_size)
+	{
+		tile_size = (size + std::min(tiles, size) - 1) / std::min(tiles, size);
+		return (size + tile_size - 1) / tile_size;
+	};
+	int tile_width    = 0;
+	int tile_height   = 0;
+	const int columns = axis_tiles(image.width, tile_width);
+	const int rows    = axis_tiles(image.height, tile_height);
+	std::vector<ClaheProcessor::Table> tables;
+	for (int ty = 0; ty < rows; ++ty)
+	{
+		for (int tx = 0; tx < columns; ++tx)
+		{
+			ClaheProcessor::Histogram hist{};
+			uint32_t count = 0;
+			for (int y = ty * tile_height; y < std::min(image.height, (ty + 1) * tile_height); ++y)
+			{
+				for (int x = tx * tile_width; x < std::min(image.width, (tx + 1) * tile_width); ++x)
+				{
+					++hist[image.pixels[y * image.width + x]];
+					++count;
+				}
+			}
+			tables.push_back(ClaheProcessor::clipped_table(hist, count, clip_limit));
+		}
+	}
+
+	// nearest tile centers below and above position p and the weight of the upper one
+	auto neighbours = [](int p, int tile_size, int count, int& t0, int& t1)
+	{
+		const double f = (p + 0.5) / tile_size - 0.5;
+		t0             = std::clamp(static_cast<int>(std::floor(f)), 0, count - 1);
+		t1             = std::clamp(static_cast<int>(std::floor(f)) + 1, 0, count - 1);
+		return t0 == t1 ? 0.0 : f - std::floor(f);
+	};
+
+	imgclean::GSImage out = image;
+	for (int y = 0; y < image.height; ++y)
+	{
+		int ty0 = 0, ty1 = 0;
+		const double wy                     = neighbours(y, tile_height, rows, ty0, ty1);
+		const ClaheProcessor::Table* top    = &tables[ty0 * columns];
+		const ClaheProcessor::Table* bottom = &tables[ty1 * columns];
+		for (int x = 0; x < image.width; ++x)
+		{
+			int tx0 = 0, tx1 = 0;
+			const double wx     = neighbours(x, tile_width, columns, tx0, tx1);
+			const uint8_t value = image.pixels[y * image.width + x];
+			const double upper  = (1.0 - wx) * top[tx0][value] + wx * top[tx1][value];
+			const double lower  = (1.0 - wx) * bottom[tx0][value] + wx * bottom[tx1][value];
+			out.pixels[y * image.width + x] = static_cast<uint8_t>(std::lround((1.0 - wy) * upper + wy * lower));
+		}
+	}
+	return out;
+}
+
+TEST_CASE("Several tiles match a float bilinear reference", "[ClaheProcessor]")
+{
+	// sizes not divisible by the tile count, the last tile row and column are cut short
+	const imgclean::GSImage image = make_document_image(203, 157, 11);
+	for (const auto& [tiles, clip_limit] : {std::pair{8, 2.0f}, std::pair{5, 4.0f}, std::pair{3, 256.0f}})
+	{
+		const imgclean::GSImage output_image = ClaheProcessor::apply(image, tiles, clip_limit);
+		const imgclean::GSImage reference    = clahe_reference(image, tiles, clip_limit);
+		REQUIRE(output_image.pixels.size() == reference.pixels.size());
+
+		// the fixed-point weights round to 1/256
+		int max_difference = 0;
+		for (size_t i = 0; i < reference.pixels.size(); ++i)
+		{
+			max_difference = std::max(max_difference, std::abs(output_image.pixels[i] - reference.pixels[i]));
+		}
+		REQUIRE(max_difference <= 1);
+	}
+}
@@ -0,0 +1,86 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/DespeckleProcessor.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include <vector>
+
+using imgclean::BinaryImage;
+using imgclean::processors::DespeckleProcessor;
+
+//! Brute force: flood fills every 8-connected component and clears those of less than min_area pixels
+static BinaryImage brute_force_despeckle(const BinaryImage& image, int min_area)
+{
+	BinaryImage output_image = image;
+	std::vector<bool> visited(image.pixel_count(), false);
+	std::vector<std::pair<int, int>> component, stack;
+	for (int y = 0; y < image.height; ++y)
+	{
+		for (int x = 0; x < image.width; ++x)
+		{
+			if (!image.get(x, y) || visited[y * image.width + x]) continue;
+			component.clear();
+			stack.assign(1, {x, y});
+			visited[y * image.width + x] = true;
+			while (!stack.empty())
+			{
+				const auto [px, py] = stack.back();
+				stack.pop_back();
+				component.push_back({px, py});
+				for (int v = py - 1; v <= py + 1; ++v)
+				{
+					for (int u = px - 1; u <= px + 1; ++u)
+					{
+						if (u < 0 || v < 0 || u >= image.width || v >= image.height) continue;
+						if (!image.get(u, v) || visited[v * image.width + u]) continue;
+						visited[v * image.width + u] = true;
+						stack.push_back({u, v});
+					}
+				}
+			}
+			if (static_cast<int>(component.size()) >= min_area) continue;
+			for (const auto& [px, py] : component) output_image.set(px, py, false);
+		}
+	}
+	return output_image;
+}
+
+TEST_CASE("Despeckle matches the brute force component areas", "[DespeckleProcessor]")
+{
+	// noisy page over several labeling bands, widths inside and at the end of a word
+	for (int width : {131, 128})
+	{
+		const imgclean::GSImage gray = make_document_image(width, 300, 11);
+		const BinaryImage binary     = imgclean::processors::HelperProcessor::grayscale_to_binary(gray, 60);
+		for (int min_area : {1, 2, 8, 40, 500})
+		{
+			INFO(width << " " << min_area);
+			REQUIRE(DespeckleProcessor::apply(binary, min_area).words ==
+			        brute_force_despeckle(binary, min_area).words);
+		}
+	}
+}
+
+TEST_CASE("Despeckle connects diagonals and band borders", "[DespeckleProcessor]")
+{
+	BinaryImage image;
+	image.resize(200, 400);
+	// a diagonal line of 190 pixels across a band border
+	for (int i = 0; i < 190; ++i) image.set(i, 50 + i, true);
+	// a single dot and a 2x2 block
+	image.set(150, 10, true);
+	image.set(10, 390, true);
+	image.set(11, 390, true);
+	image.set(10, 391, true);
+	image.set(11, 391, true);
+
+	const BinaryImage output_image = DespeckleProcessor::apply(image, 5);
+	REQUIRE_FALSE(output_image.get(150, 10));
+	REQUIRE_FALSE(output_image.get(10, 390));
+	for (int i = 0; i < 190; ++i) REQUIRE(output_image.get(i, 50 + i));
+	REQUIRE(DespeckleProcessor::apply(image, 190).get(0, 50));
+	REQUIRE_FALSE(DespeckleProcessor::apply(image, 191).get(0, 50));
+
+	REQUIRE(DespeckleProcessor::apply(image, 4).get(11, 391));
+	REQUIRE(DespeckleProcessor::apply(BinaryImage(), 8).empty());
+}
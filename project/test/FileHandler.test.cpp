@@ -1,6 +1,10 @@
 #include "catch.hpp"
 
 #include "imgclean/FileHandler.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <string>
 
 #ifdef CIMG_FOUND
@@ -109,3 +113,311 @@ TEST_CASE("FileHandler JPG Saving", "[FileHandler][JPG]")
 	REQUIRE(!save_success);
 #endif
 }
+
+//! Reads a whole file into a string
+static std::string read_file(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+//! 3x2 gray scale image used by the single-channel saving tests
+static imgclean::GSImage make_gray_test_image()
+{
+	imgclean::GSImage img;
+	img.width  = 3;
+	img.height = 2;
+	img.pixels = {0, 255, 103, 255, 0, 7};
+	return img;
+}
+
+TEST_CASE("FileHandler PGM Saving", "[FileHandler][PGM]")
+{
+	const imgclean::GSImage img = make_gray_test_image();
+
+	imgclean::FilePath binary_path = imgclean::FileHandler::make_file_path("../build/test_output/3x2-gray.pgm");
+	REQUIRE(binary_path.format == imgclean::ImageFormat::PGM_BINARY);
+	REQUIRE(imgclean::FileHandler::save_image(binary_path, img));
+	REQUIRE(read_file(binary_path.path) == std::string("P5\n3 2\n255\n\x00\xff\x67\xff\x00\x07", 17));
+
+	imgclean::FilePath ascii_path{"../build/test_output/3x2-gray-ascii.pgm", imgclean::ImageFormat::PGM_ASCII};
+	REQUIRE(imgclean::FileHandler::save_image(ascii_path, img));
+	REQUIRE(read_file(ascii_path.path) == "P2\n3 2\n255\n0 255 103\n255 0 7\n");
+
+	// RGB images cannot be written as PGM
+	imgclean::PPMImage rgb;
+	rgb.width  = 1;
+	rgb.height = 1;
+	rgb.pixels = {1, 2, 3};
+	REQUIRE(!imgclean::FileHandler::save_image(binary_path, rgb));
+}
+
+TEST_CASE("FileHandler ASCII PPM Saving from gray scale", "[FileHandler][PPM]")
+{
+	imgclean::FilePath path = imgclean::FileHandler::make_file_path("../build/test_output/3x2-gray.ppm");
+	REQUIRE(imgclean::FileHandler::save_image(path, make_gray_test_image()));
+	REQUIRE(read_file(path.path) == "P3\n3 2\n255\n0 0 0\n255 255 255\n103 103 103\n255 255 255\n0 0 0\n7 7 7\n");
+
+	imgclean::PPMImage loaded;
+	REQUIRE(imgclean::FileHandler::load_image(path, loaded));
+	REQUIRE(loaded.width == 3);
+	REQUIRE(loaded.height == 2);
+}
+
+TEST_CASE("FileHandler grayscale PNG and JPG Saving", "[FileHandler][PNG][JPG]")
+{
+	const imgclean::GSImage img = make_gray_test_image();
+	imgclean::FilePath png_path = imgclean::FileHandler::make_file_path("../build/test_output/3x2-gray.png");
+	imgclean::FilePath jpg_path = imgclean::FileHandler::make_file_path("../build/test_output/3x2-gray.jpg");
+	const bool png_success      = imgclean::FileHandler::save_image(png_path, img);
+	const bool jpg_success      = imgclean::FileHandler::save_image(jpg_path, img);
+#ifdef CIMG_FOUND
+	REQUIRE(png_success);
+	REQUIRE(jpg_success);
+
+	// PNG is lossless and loads back as RGB with three equal channels
+	imgclean::PPMImage loaded;
+	REQUIRE(imgclean::FileHandler::load_image(png_path, loaded));
+	REQUIRE(loaded.width == 3);
+	REQUIRE(loaded.height == 2);
+	for (size_t i = 0; i < img.pixels.size(); ++i)
+	{
+		REQUIRE(loaded.pixels[i * 3 + 0] == img.pixels[i]);
+		REQUIRE(loaded.pixels[i * 3 + 1] == img.pixels[i]);
+		REQUIRE(loaded.pixels[i * 3 + 2] == img.pixels[i]);
+	}
+#else
+	REQUIRE(!png_success);
+	REQUIRE(!jpg_success);
+#endif
+}
+
+//! Writes raw bytes to a file in the test output directory and returns its path
+static std::string write_test_file(const std::string& name, const std::string& bytes)
+{
+	std::filesystem::create_directories("../build/test_output");
+	const std::string path = "../build/test_output/" + name;
+	std::ofstream file(path, std::ios::binary);
+	file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	return path;
+}
+
+TEST_CASE("FileHandler binary PPM and PGM Loading", "[FileHandler][PPM][PGM]")
+{
+	// a P6 file named .ppm: the extension only picks the variant written (P3), loading reads the magic number
+	const std::string ppm =
+		write_test_file("2x1-binary.ppm", std::string("P6\n# comment\n2 1\n255\n\x01\x02\x03\xfd\xfe\xff", 27));
+	REQUIRE(imgclean::FileHandler::detect_format(ppm) == imgclean::ImageFormat::PPM_ASCII);
+	imgclean::PPMImage img;
+	REQUIRE(imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(ppm), img));
+	REQUIRE(img.width == 2);
+	REQUIRE(img.height == 1);
+	REQUIRE(img.pixels == std::vector<uint16_t>{1, 2, 3, 253, 254, 255});
+
+	// gray values are repeated for R, G and B
+	const std::string pgm = write_test_file("3x1-binary.pgm", std::string("P5 3 1 255 \x00\x67\xff", 14));
+	REQUIRE(imgclean::FileHandler::detect_format(pgm) == imgclean::ImageFormat::PGM_BINARY);
+	REQUIRE(imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(pgm), img));
+	REQUIRE(img.pixels == std::vector<uint16_t>{0, 0, 0, 103, 103, 103, 255, 255, 255});
+
+	// 16-bit samples are big-endian
+	const std::string wide = write_test_file("2x1-wide.pgm", std::string("P5\n2 1\n65535\n\x12\x34\xff\xfe", 17));
+	REQUIRE(imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(wide), img));
+	REQUIRE(img.maxval == 65535);
+	REQUIRE(img.pixels == std::vector<uint16_t>{0x1234, 0x1234, 0x1234, 0xfffe, 0xfffe, 0xfffe});
+
+	// truncated bodies and samples above maxval are rejected
+	const std::string truncated = write_test_file("truncated.ppm", std::string("P6\n2 1\n255\n\x01\x02\x03", 14));
+	REQUIRE(!imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(truncated), img));
+	REQUIRE(img.empty());
+	const std::string above = write_test_file("above.pgm", std::string("P5\n2 1\n100\n\x10\x65", 13));
+	REQUIRE(!imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(above), img));
+}
+
+TEST_CASE("FileHandler binary PPM Saving", "[FileHandler][PPM]")
+{
+	imgclean::FilePath path{"../build/test_output/3x3-test-output-binary.ppm", imgclean::ImageFormat::PPM_BINARY};
+	imgclean::PPMImage img;
+	REQUIRE(imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path("../res/test/3x3-test.ppm"), img));
+	REQUIRE(imgclean::FileHandler::save_image(path, img));
+	REQUIRE(read_file(path.path).size() == 11 + 27);
+
+	imgclean::PPMImage loaded;
+	REQUIRE(imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(path.path), loaded));
+	REQUIRE(loaded.pixels == expected_pixels);
+
+	// the P6 file now at the path does not change the format written there, .ppm stays P3
+	const imgclean::FilePath stale = imgclean::FileHandler::make_file_path(path.path);
+	REQUIRE(stale.format == imgclean::ImageFormat::PPM_ASCII);
+	REQUIRE(imgclean::FileHandler::save_image(stale, img));
+	REQUIRE(read_file(path.path).substr(0, 3) == "P3\n");
+	REQUIRE(imgclean::FileHandler::load_image(stale, loaded));
+	REQUIRE(loaded.pixels == expected_pixels);
+
+	// binary = true writes .ppm as P6, plain takes precedence
+	const imgclean::FilePath binary = imgclean::FileHandler::make_file_path(path.path, false, true);
+	REQUIRE(binary.format == imgclean::ImageFormat::PPM_BINARY);
+	REQUIRE(imgclean::FileHandler::make_file_path(path.path, true, true).format == imgclean::ImageFormat::PPM_ASCII);
+	REQUIRE(imgclean::FileHandler::save_image(binary, img));
+	REQUIRE(read_file(path.path).substr(0, 3) == "P6\n");
+	REQUIRE(imgclean::FileHandler::load_image(binary, loaded));
+	REQUIRE(loaded.pixels == expected_pixels);
+
+	// above maxval 255 every sample takes two bytes
+	img.maxval = 1000;
+	img.pixels[4] = 999;
+	REQUIRE(imgclean::FileHandler::save_image(path, img));
+	REQUIRE(read_file(path.path).substr(0, 12) == "P6\n3 3\n1000\n");
+	REQUIRE(imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(path.path), loaded));
+	REQUIRE(loaded.maxval == 1000);
+	REQUIRE(loaded.pixels == img.pixels);
+
+	// a gray scale image repeats its values
+	imgclean::FilePath gray_path{"../build/test_output/3x2-gray-binary.ppm", imgclean::ImageFormat::PPM_BINARY};
+	REQUIRE(imgclean::FileHandler::save_image(gray_path, make_gray_test_image()));
+	REQUIRE(read_file(gray_path.path) ==
+	        std::string("P6\n3 2\n255\n\x00\x00\x00\xff\xff\xff\x67\x67\x67\xff\xff\xff\x00\x00\x00\x07\x07\x07", 29));
+}
+
+TEST_CASE("FileHandler ASCII PPM Loading in parallel chunks", "[FileHandler][PPM]")
+{
+	// several MiB of text, so the body is split into many chunks
+	imgclean::PPMImage img;
+	img.width  = 640;
+	img.height = 480;
+	img.pixels.resize(img.pixel_count() * 3);
+	for (size_t i = 0; i < img.pixels.size(); ++i)
+	{
+		img.pixels[i] = static_cast<uint16_t>((i * 7919) % 256);
+	}
+	const imgclean::FilePath path = imgclean::FileHandler::make_file_path("../build/test_output/640x480.ppm");
+	REQUIRE(imgclean::FileHandler::save_image(path, img));
+	imgclean::PPMImage loaded;
+	REQUIRE(imgclean::FileHandler::load_image(path, loaded));
+	REQUIRE(std::equal(loaded.pixels.begin(), loaded.pixels.end(), img.pixels.begin(), img.pixels.end()));
+
+	// comments holding digits and whitespace on every line, numbers glued to comments
+	std::string text = read_file(path.path);
+	std::string commented;
+	for (size_t pos = 0, line = 0; pos < text.size(); ++line)
+	{
+		const size_t eol = text.find('\n', pos);
+		commented.append(text, pos, eol - pos);
+		commented += line % 3 == 0 ? "# 1 2 3 4\n" : "\n";
+		pos = eol + 1;
+	}
+	const std::string commented_path = write_test_file("640x480-comments.ppm", commented);
+	REQUIRE(imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(commented_path), loaded));
+	REQUIRE(std::equal(loaded.pixels.begin(), loaded.pixels.end(), img.pixels.begin(), img.pixels.end()));
+
+	// anything behind the last pixel is ignored
+	const std::string trailing_path = write_test_file("640x480-trailing.ppm", text + "1 x -3");
+	REQUIRE(imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(trailing_path), loaded));
+	REQUIRE(std::equal(loaded.pixels.begin(), loaded.pixels.end(), img.pixels.begin(), img.pixels.end()));
+
+	// a missing last value, a value that is no number or a value above maxval fail in any chunk
+	std::string missing = text;
+	missing.resize(missing.find_last_of(' '));
+	std::string word = text;
+	word.replace(text.size() / 2, 1, "x");
+	std::string above = text;
+	above.replace(above.find_last_of(' ') + 1, 0, "999");
+	for (const std::string& broken : {missing, word, above})
+	{
+		const std::string broken_path = write_test_file("640x480-broken.ppm", broken);
+		REQUIRE(!imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(broken_path), loaded));
+		REQUIRE(loaded.empty());
+	}
+}
+
+TEST_CASE("FileHandler ASCII PPM Loading of 16-bit samples", "[FileHandler][PPM]")
+{
+	// numbers of 1 to 5 digits, a few with leading zeros, crossing the 64-byte blocks everywhere
+	imgclean::PPMImage img;
+	img.width  = 300;
+	img.height = 20;
+	img.maxval = 65535;
+	img.pixels.resize(img.pixel_count() * 3);
+	std::string text = "P3\n300 20\n65535\n";
+	for (size_t i = 0; i < img.pixels.size(); ++i)
+	{
+		const uint32_t limits[] = {10, 100, 1000, 10000, 65536};
+		const uint32_t value    = static_cast<uint32_t>((i * 2654435761u) >> 8) % limits[i % 5];
+		img.pixels[i]           = static_cast<uint16_t>(value);
+		text += (i % 97 == 0 ? "0000000" : "") + std::to_string(value) + (i % 7 == 0 ? "\n" : "  ");
+	}
+	const std::string path = write_test_file("300x20-wide.ppm", text);
+	imgclean::PPMImage loaded;
+	REQUIRE(imgclean::FileHandler::load_image(imgclean::FileHandler::make_file_path(path), loaded));
+	REQUIRE(loaded.maxval == 65535);
+	REQUIRE(std::equal(loaded.pixels.begin(), loaded.pixels.end(), img.pixels.begin(), img.pixels.end()));
+
+	// a number above maxval fails, whether it takes 5 digits or more
+	for (const char* value : {" 65536 ", " 100000 ", " 0000065536 "})
+	{
+		std::string above = text;
+		above.replace(above.size() / 2, 1, value);
+		REQUIRE(!imgclean::FileHandler::load_image(
+			imgclean::FileHandler::make_file_path(write_test_file("300x20-above.ppm", above)), loaded));
+	}
+}
+
+TEST_CASE("FileHandler ASCII PPM and PGM Saving in parallel bands", "[FileHandler][PPM][PGM]")
+{
+	// several MiB of text, so the body is formatted in many bands and rounds
+	imgclean::PPMImage img;
+	img.width  = 1000;
+	img.height = 900;
+	img.pixels.resize(img.pixel_count() * 3);
+	for (size_t i = 0; i < img.pixels.size(); ++i)
+	{
+		img.pixels[i] = static_cast<uint16_t>((i * 2654435761u >> 12) % 256);
+	}
+	const imgclean::FilePath path{"../build/test_output/1000x900-bands.ppm", imgclean::ImageFormat::PPM_ASCII};
+	imgclean::PPMImage loaded;
+	REQUIRE(imgclean::FileHandler::save_image(path, img));
+	REQUIRE(imgclean::FileHandler::load_image(path, loaded));
+	REQUIRE(loaded.width == img.width);
+	REQUIRE(loaded.height == img.height);
+	REQUIRE(std::equal(loaded.pixels.begin(), loaded.pixels.end(), img.pixels.begin(), img.pixels.end()));
+
+	// samples above 255 are written with all their digits
+	img.maxval = 65535;
+	for (size_t i = 0; i < img.pixels.size(); i += 5)
+	{
+		img.pixels[i] = static_cast<uint16_t>(65535 - i % 65536);
+	}
+	REQUIRE(imgclean::FileHandler::save_image(path, img));
+	REQUIRE(imgclean::FileHandler::load_image(path, loaded));
+	REQUIRE(loaded.maxval == 65535);
+	REQUIRE(std::equal(loaded.pixels.begin(), loaded.pixels.end(), img.pixels.begin(), img.pixels.end()));
+
+	// P2 starts every image row on a new line and breaks it after every 17 values
+	imgclean::GSImage gray;
+	gray.width  = 1500;
+	gray.height = 1200;
+	gray.pixels.resize(gray.pixel_count());
+	std::string expected = "P2\n1500 1200\n255\n";
+	for (size_t i = 0; i < gray.pixels.size(); ++i)
+	{
+		gray.pixels[i]        = static_cast<uint8_t>((i * 2654435761u >> 16) % 256);
+		const size_t x        = i % 1500;
+		const bool break_line = x == 1499 || x % 17 == 16;
+		expected += std::to_string(gray.pixels[i]) + (break_line ? "\n" : " ");
+	}
+	const imgclean::FilePath gray_path = imgclean::FileHandler::make_file_path(
+		"../build/test_output/1500x1200-bands.pgm", true);
+	REQUIRE(gray_path.format == imgclean::ImageFormat::PGM_ASCII);
+	REQUIRE(imgclean::FileHandler::save_image(gray_path, gray));
+	const std::string text = read_file(gray_path.path);
+	REQUIRE((text == expected));
+
+	// no line is longer than the 70 characters netpbm allows
+	size_t longest = 0;
+	for (size_t begin = 0, end = 0; begin < text.size(); begin = end + 1)
+	{
+		end     = text.find('\n', begin);
+		longest = std::max(longest, end - begin);
+	}
+	REQUIRE(longest <= 70);
+}
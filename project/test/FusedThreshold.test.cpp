@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/IntegralImageProcessor.hpp"
+#include "imgclean/processors/NiblackProcessor.hpp"
+#include "imgclean/processors/SauvolaProcessor.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace imgclean::processors;
+
+//! RGB page with slightly different channels, scaled to maxval
+static imgclean::PPMImage make_rgb_page(int width, int height, int maxval)
+{
+	const imgclean::GSImage gray = make_document_image(width, height, 11);
+	imgclean::PPMImage image;
+	image.width  = width;
+	image.height = height;
+	image.maxval = maxval;
+	for (uint8_t value : gray.pixels)
+	{
+		for (int offset : {0, 7, -9})
+		{
+			const int channel = std::min(255, std::max(0, value + offset));
+			image.pixels.push_back(static_cast<uint16_t>(channel * maxval / 255));
+		}
+	}
+	return image;
+}
+
+TEST_CASE("Row-wise grayscale conversion matches the full-frame one", "[FusedThreshold][HelperProcessor]")
+{
+	for (int maxval : {255, 65535})
+	{
+		const imgclean::PPMImage image = make_rgb_page(1500, 3, maxval);
+		const imgclean::GSImage gray   = HelperProcessor::rgb_to_linear_grayscale(image);
+
+		std::vector<uint8_t> rows(image.pixel_count());
+		const uint16_t scale = HelperProcessor::max_luma(image);
+		for (int y = 0; y < image.height; ++y)
+		{
+			const size_t offset = static_cast<size_t>(y) * image.width;
+			HelperProcessor::linear_grayscale_row(image.pixels.data() + offset * 3, image.width, scale,
+			                                      rows.data() + offset);
+		}
+		REQUIRE(rows == gray.pixels);
+	}
+}
+
+TEST_CASE("Fused thresholds match conversion and processor", "[FusedThreshold]")
+{
+	const WindowEngine engine = WindowEngine::SLIDING_WINDOW;
+
+	// tall enough for several bands, narrow images are smaller than the window
+	for (auto [width, height] : {std::pair{173, 301}, std::pair{9, 40}})
+	{
+		for (int maxval : {255, 1023})
+		{
+			const imgclean::PPMImage image = make_rgb_page(width, height, maxval);
+			const imgclean::GSImage gray   = HelperProcessor::rgb_to_linear_grayscale(image);
+
+			for (int window : {1, 15, 21, 63})
+			{
+				INFO(width << "x" << height << ", maxval " << maxval << ", window " << window);
+				REQUIRE(IntegralImageProcessor::apply_rgb(image, window, 0.9f).words ==
+				        IntegralImageProcessor::apply_binary(gray, engine, window, 0.9f).words);
+				REQUIRE(NiblackProcessor::apply_rgb(image, window).words ==
+				        NiblackProcessor::apply_binary(gray, engine, window).words);
+				REQUIRE(SauvolaProcessor::apply_rgb(image, window, 0.3f).words ==
+				        SauvolaProcessor::apply_binary(gray, engine, window, 0.3f).words);
+			}
+		}
+	}
+
+	REQUIRE(SauvolaProcessor::apply_rgb(imgclean::PPMImage()).empty());
+	REQUIRE(SauvolaProcessor::apply_rgb(make_rgb_page(10, 10, 255), 4).empty());
+}
@@ -0,0 +1,70 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/GaussianProcessor.hpp"
+#include <algorithm>
+#include <cmath>
+
+using imgclean::processors::GaussianProcessor;
+
+TEST_CASE("Box filter matches the brute force clipped mean", "[GaussianProcessor]")
+{
+	const imgclean::GSImage image = make_document_image(97, 61, 5);
+	for (int window : {1, 3, 15, 21, 131})
+	{
+		INFO("window " << window);
+		const int half                    = window / 2;
+		const imgclean::GSImage filtered = GaussianProcessor::box_filter(image, window);
+		REQUIRE(filtered.pixels.size() == image.pixels.size());
+		bool all_equal = true;
+		const int w = image.width;
+		const int h = image.height;
+		for (int y = 0; y < h; ++y)
+		{
+			for (int x = 0; x < w; ++x)
+			{
+				int sum = 0, count = 0;
+				for (int v = std::max(0, y - half); v <= std::min(h - 1, y + half); ++v)
+				{
+					for (int u = std::max(0, x - half); u <= std::min(w - 1, x + half); ++u)
+					{
+						sum += image.pixels[v * w + u];
+						++count;
+					}
+				}
+				all_equal &= filtered.pixels[y * w + x] == (2 * sum + count) / (2 * count);
+			}
+		}
+		REQUIRE(all_equal);
+	}
+	REQUIRE(GaussianProcessor::box_filter(image, 2).empty());
+}
+
+TEST_CASE("Stacked boxes approximate the Gaussian variance", "[GaussianProcessor]")
+{
+	for (float sigma : {2.0f, 3.5f, 10.0f, 40.0f})
+	{
+		INFO("sigma " << sigma);
+		double variance = 0.0;
+		for (int window : GaussianProcessor::box_sizes(sigma))
+		{
+			REQUIRE(window % 2 == 1);
+			variance += (static_cast<double>(window) * window - 1.0) / 12.0;
+		}
+		REQUIRE(std::abs(std::sqrt(variance) - sigma) < 0.1 * sigma);
+	}
+
+	// a flat page stays flat, the stages are three box passes
+	const imgclean::GSImage image = make_document_image(80, 50, 3);
+	imgclean::GSImage flat        = image;
+	std::fill(flat.pixels.begin(), flat.pixels.end(), 123);
+	REQUIRE(GaussianProcessor::apply(flat, 3.0f).pixels == flat.pixels);
+
+	imgclean::GSImage expected = image;
+	for (int window : GaussianProcessor::box_sizes(3.0f))
+	{
+		expected = GaussianProcessor::box_filter(expected, window);
+	}
+	REQUIRE(GaussianProcessor::apply(image, 3.0f).pixels == expected.pixels);
+	REQUIRE(GaussianProcessor::apply(image, 0.0f).empty());
+}
@@ -0,0 +1,84 @@
+#include "catch.hpp"
+
+#include "imgclean/processors/HelperProcessor.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+//! Reference in exact integer arithmetic: luma = round(0.299 r + 0.587 g + 0.114 b), then round(luma * 255 / max)
+static std::vector<int> gray_reference(const imgclean::PPMImage& image, int& max_luma)
+{
+	std::vector<int> luma(image.pixel_count());
+	max_luma = 0;
+	for (size_t i = 0; i < luma.size(); ++i)
+	{
+		const uint16_t* rgb = &image.pixels[i * 3];
+		const int weighted  = 299 * rgb[0] + 587 * rgb[1] + 114 * rgb[2];
+		luma[i]             = (weighted + 500) / 1000;
+		max_luma            = std::max(max_luma, luma[i]);
+	}
+	std::vector<int> out(luma.size());
+	for (size_t i = 0; i < luma.size(); ++i)
+		out[i] = static_cast<int>((2ll * luma[i] * 255 + max_luma) / (2ll * max_luma));
+	return out;
+}
+
+//! Pseudo-random RGB image with the given sample range
+static imgclean::PPMImage make_rgb_image(int width, int height, int maxval)
+{
+	imgclean::PPMImage image;
+	image.width  = width;
+	image.height = height;
+	image.maxval = maxval;
+	image.pixels.resize(image.pixel_count() * 3);
+	uint32_t state = 42;
+	for (auto& sample : image.pixels)
+	{
+		state  = state * 1664525u + 1013904223u;
+		sample = static_cast<uint16_t>((state >> 8) % (static_cast<uint32_t>(maxval) + 1));
+	}
+	return image;
+}
+
+TEST_CASE("Fixed-point grayscale conversion matches the exact formula", "[HelperProcessor]")
+{
+	// odd sizes so that the vector loop leaves a scalar tail
+	for (int maxval : {255, 200, 1023, 65535})
+	{
+		const imgclean::PPMImage image = make_rgb_image(67, 31, maxval);
+		const imgclean::GSImage gray   = imgclean::processors::HelperProcessor::rgb_to_linear_grayscale(image);
+		int max_luma               = 0;
+		const std::vector<int> ref = gray_reference(image, max_luma);
+
+		REQUIRE(gray.width == image.width);
+		REQUIRE(gray.height == image.height);
+		REQUIRE(gray.maxval == 255);
+		REQUIRE(gray.pixels.size() == ref.size());
+
+		// Q16 weights may round the luma of near-ties differently, the rescale by 255 / max_luma amplifies that
+		const int tolerance = (255 + max_luma - 1) / max_luma;
+		size_t exact        = 0;
+		for (size_t i = 0; i < ref.size(); ++i)
+		{
+			REQUIRE(std::abs(static_cast<int>(gray.pixels[i]) - ref[i]) <= tolerance);
+			if (gray.pixels[i] == ref[i]) ++exact;
+		}
+		REQUIRE(exact >= ref.size() * 99 / 100);
+		REQUIRE(*std::max_element(gray.pixels.begin(), gray.pixels.end()) == 255);
+	}
+}
+
+TEST_CASE("Grayscale conversion of pure colors", "[HelperProcessor]")
+{
+	imgclean::PPMImage image;
+	image.width  = 5;
+	image.height = 1;
+	image.pixels = {255, 255, 255, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0};
+
+	const imgclean::GSImage gray = imgclean::processors::HelperProcessor::rgb_to_linear_grayscale(image);
+	REQUIRE(gray.pixels == std::vector<uint8_t>{255, 76, 150, 29, 0});
+
+	const imgclean::PPMImage rgb = imgclean::processors::HelperProcessor::grayscale_to_rgb(gray);
+	REQUIRE(rgb.pixels == std::vector<uint16_t>{255, 255, 255, 76, 76, 76, 150, 150, 150, 29, 29, 29, 0, 0, 0});
+}
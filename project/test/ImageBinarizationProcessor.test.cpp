@@ -0,0 +1,176 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/ImageBinarizationProcessor.hpp"
+#include "imgclean/processors/LocalStatistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <omp.h>
+#include <vector>
+
+//! Reference implementation that scans every window twice (mean, then stddev)
+static imgclean::GSImage binarize_naive(const imgclean::GSImage& image, int half_window)
+{
+	const int width         = image.width;
+	const int height        = image.height;
+	const size_t num_pixels = image.pixels.size();
+	const uint8_t* pixels   = image.pixels.data();
+
+	std::vector<float> windows_mean(num_pixels);
+	std::vector<float> windows_stddev(num_pixels);
+	float w_min_stddev = std::numeric_limits<float>::max();
+	float w_max_stddev = std::numeric_limits<float>::min();
+
+	for (int j = 0; j < height; ++j)
+	{
+		for (int i = 0; i < width; ++i)
+		{
+			int x1 = std::max(0, i - half_window);
+			int y1 = std::max(0, j - half_window);
+			int x2 = std::min(width - 1, i + half_window);
+			int y2 = std::min(height - 1, j + half_window);
+
+			float acc = 0;
+			for (int y = y1; y <= y2; ++y)
+				for (int x = x1; x <= x2; ++x)
+					acc += pixels[y * width + x];
+			const float mean = acc / ((x2 - x1 + 1) * (y2 - y1 + 1));
+
+			float stddev = 0.0f;
+			for (int y = y1; y <= y2; ++y)
+			{
+				for (int x = x1; x <= x2; ++x)
+				{
+					float diff = pixels[y * width + x] - mean;
+					stddev += diff * diff;
+				}
+			}
+			stddev = std::sqrt(stddev / ((x2 - x1 + 1) * (y2 - y1 + 1)));
+
+			w_max_stddev                  = std::max(w_max_stddev, stddev);
+			w_min_stddev                  = std::min(w_min_stddev, stddev);
+			windows_mean[j * width + i]   = mean;
+			windows_stddev[j * width + i] = stddev;
+		}
+	}
+
+	imgclean::GSImage out = image;
+	const float global_mean = std::accumulate(pixels, pixels + num_pixels, 0.0f) / static_cast<float>(num_pixels);
+	for (size_t index = 0; index < num_pixels; ++index)
+	{
+		const float s  = windows_stddev[index];
+		float adaptive = 0.0f;
+		if (w_max_stddev > w_min_stddev) adaptive = (s - w_min_stddev) / (w_max_stddev - w_min_stddev);
+		const float threshold = s - (windows_mean[index] * windows_mean[index] - s) /
+		                                    ((global_mean + s) * (adaptive + s));
+		out.pixels[index] = (pixels[index] < threshold) ? 0 : 255;
+	}
+	return out;
+}
+
+TEST_CASE("LocalStatistics matches brute force window statistics", "[LocalStatistics]")
+{
+	const imgclean::GSImage image = make_document_image(37, 29, 7);
+	const auto stats              = imgclean::processors::LocalStatistics::compute(image);
+
+	const int windows[][4] = {
+		{0, 0, 0, 0}, {0, 0, 36, 28}, {3, 5, 17, 19}, {30, 20, 36, 28}, {10, 0, 10, 28},
+	};
+	for (const auto& w : windows)
+	{
+		double acc = 0.0, acc_sq = 0.0;
+		for (int y = w[1]; y <= w[3]; ++y)
+		{
+			for (int x = w[0]; x <= w[2]; ++x)
+			{
+				const double v = image.pixels[y * image.width + x];
+				acc += v;
+				acc_sq += v * v;
+			}
+		}
+		const double count  = (w[2] - w[0] + 1) * (w[3] - w[1] + 1);
+		const double mean   = acc / count;
+		const double stddev = std::sqrt(std::max(0.0, acc_sq / count - mean * mean));
+
+		float got_mean = 0.0f, got_stddev = 0.0f;
+		stats.window(w[0], w[1], w[2], w[3], got_mean, got_stddev);
+		REQUIRE(got_mean == Approx(mean).epsilon(1e-6));
+		REQUIRE(got_stddev == Approx(stddev).margin(1e-4));
+	}
+}
+
+TEST_CASE("Adaptive binarization matches the windowed reference", "[ImageBinarizationProcessor]")
+{
+	const imgclean::GSImage image = make_document_image(160, 120);
+	const imgclean::GSImage fast  = imgclean::processors::ImageBinarizationProcessor::apply(image);
+	const imgclean::GSImage ref   = binarize_naive(image, 7);
+
+	REQUIRE(fast.width == ref.width);
+	REQUIRE(fast.height == ref.height);
+	REQUIRE(fast.pixels.size() == ref.pixels.size());
+
+	// float rounding differs between the two-pass and the integral variance -> allow a few flips
+	size_t mismatches = 0;
+	for (size_t i = 0; i < fast.pixels.size(); ++i)
+	{
+		REQUIRE((fast.pixels[i] == 0 || fast.pixels[i] == 255));
+		if (fast.pixels[i] != ref.pixels[i]) ++mismatches;
+	}
+	REQUIRE(mismatches <= fast.pixels.size() / 1000);
+}
+
+TEST_CASE("Adaptive binarization is independent of the thread count", "[ImageBinarizationProcessor]")
+{
+	// height is not a multiple of the row tile size on purpose
+	const imgclean::GSImage image = make_document_image(97, 203, 3);
+	const int default_threads     = omp_get_max_threads();
+
+	omp_set_num_threads(1);
+	const imgclean::GSImage serial = imgclean::processors::ImageBinarizationProcessor::apply(image);
+	omp_set_num_threads(4);
+	const imgclean::GSImage parallel = imgclean::processors::ImageBinarizationProcessor::apply(image);
+	omp_set_num_threads(default_threads);
+
+	REQUIRE(serial.pixels == parallel.pixels);
+}
+
+TEST_CASE("Adaptive binarization engines agree", "[ImageBinarizationProcessor][BoxSumEngine]")
+{
+	using imgclean::processors::WindowEngine;
+	const imgclean::GSImage image    = make_document_image(130, 290, 17);
+	const imgclean::GSImage integral = imgclean::processors::ImageBinarizationProcessor::apply(image);
+	const imgclean::GSImage sliding  = imgclean::processors::ImageBinarizationProcessor::apply(
+		image, WindowEngine::SLIDING_WINDOW);
+	REQUIRE(sliding.pixels == integral.pixels);
+}
+
+TEST_CASE("Adaptive binarization of an empty image", "[ImageBinarizationProcessor]")
+{
+	REQUIRE(imgclean::processors::ImageBinarizationProcessor::apply(imgclean::GSImage()).empty());
+}
+
+TEST_CASE("Adaptive binarization honors the window size", "[ImageBinarizationProcessor]")
+{
+	using imgclean::processors::ImageBinarizationProcessor;
+	using imgclean::processors::WindowEngine;
+	const imgclean::GSImage image = make_document_image(140, 100, 8);
+
+	for (int window : {9, 31})
+	{
+		const auto ref      = binarize_naive(image, window / 2);
+		const auto integral = ImageBinarizationProcessor::apply(image, WindowEngine::INTEGRAL_IMAGE, window);
+		const auto sliding  = ImageBinarizationProcessor::apply(image, WindowEngine::SLIDING_WINDOW, window);
+		REQUIRE(sliding.pixels == integral.pixels);
+
+		size_t mismatches = 0;
+		for (size_t i = 0; i < ref.pixels.size(); ++i)
+		{
+			if (integral.pixels[i] != ref.pixels[i]) ++mismatches;
+		}
+		REQUIRE(mismatches <= ref.pixels.size() / 1000);
+	}
+
+	REQUIRE(ImageBinarizationProcessor::apply(image, WindowEngine::INTEGRAL_IMAGE, 8).empty());
+}
@@ -0,0 +1,194 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/IntegralImage.hpp"
+#include "imgclean/processors/IntegralImageProcessor.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <omp.h>
+#include <vector>
+
+//! Reference implementation: serial integral image and column-major threshold pass
+static imgclean::GSImage threshold_reference(const imgclean::GSImage& image, int half_window, float t)
+{
+	const int w = image.width;
+	const int h = image.height;
+	std::vector<uint32_t> integral(static_cast<size_t>(w) * h, 0);
+	for (int y = 0; y < h; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			uint32_t left       = (x > 0) ? integral[y * w + (x - 1)] : 0;
+			uint32_t above      = (y > 0) ? integral[(y - 1) * w + x] : 0;
+			uint32_t above_left = (y > 0 && x > 0) ? integral[(y - 1) * w + (x - 1)] : 0;
+			integral[y * w + x] = image.pixels[y * w + x] + left + above - above_left;
+		}
+	}
+
+	imgclean::GSImage out = image;
+	for (int i = 0; i < w; ++i)
+	{
+		for (int j = 0; j < h; ++j)
+		{
+			int x1     = std::max(0, i - half_window);
+			int y1     = std::max(0, j - half_window);
+			int x2     = std::min(w - 1, i + half_window);
+			int y2     = std::min(h - 1, j + half_window);
+			int count  = (x2 - x1 + 1) * (y2 - y1 + 1);
+			uint32_t A = integral[y2 * w + x2];
+			uint32_t B = (y1 > 0) ? integral[(y1 - 1) * w + x2] : 0;
+			uint32_t C = (x1 > 0) ? integral[y2 * w + (x1 - 1)] : 0;
+			uint32_t D = (y1 > 0 && x1 > 0) ? integral[(y1 - 1) * w + (x1 - 1)] : 0;
+
+			float local_mean      = static_cast<float>(A - B - C + D) / count;
+			out.pixels[j * w + i] = (image.pixels[j * w + i] < t * local_mean) ? 0 : 255;
+		}
+	}
+	return out;
+}
+
+TEST_CASE("Two-phase integral image matches the serial recurrence", "[IntegralImage]")
+{
+	// wider than one column block and taller than one band of rows, so that blocks carry into the bands below
+	const imgclean::GSImage image = make_document_image(600, 600, 11);
+	const size_t stride           = image.width + 1;
+	std::vector<uint64_t> integral(stride * (image.height + 1), 1);
+	imgclean::processors::build_integral_image(image, integral.data(),
+	                                           [](uint8_t v) { return static_cast<uint64_t>(v); });
+
+	for (size_t x = 0; x < stride; ++x)
+		REQUIRE(integral[x] == 0);
+
+	std::vector<uint64_t> column(image.width, 0);
+	bool all_equal = true;
+	for (int y = 0; y < image.height; ++y)
+	{
+		all_equal    = all_equal && integral[(y + 1) * stride] == 0;
+		uint64_t row = 0;
+		for (int x = 0; x < image.width; ++x)
+		{
+			row += image.pixels[y * image.width + x];
+			column[x] += row;
+			all_equal = all_equal && integral[(y + 1) * stride + x + 1] == column[x];
+		}
+	}
+	REQUIRE(all_equal);
+}
+
+TEST_CASE("Tiled integral image matches the full 64-bit integral image", "[IntegralImage]")
+{
+	// several tiles in both directions, borders not aligned to the tile size
+	const imgclean::GSImage image = make_document_image(600, 530, 21);
+	using imgclean::processors::TiledIntegralImage;
+	const auto sum    = TiledIntegralImage::build(image, [](uint8_t v) { return v; });
+	const auto sum_sq = TiledIntegralImage::build(image, [](uint8_t v) { return static_cast<uint32_t>(v) * v; });
+
+	const size_t stride = image.width + 1;
+	std::vector<uint64_t> ref(stride * (image.height + 1), 0);
+	std::vector<uint64_t> ref_sq(stride * (image.height + 1), 0);
+	imgclean::processors::build_integral_image(image, ref.data(), [](uint8_t v) { return uint64_t{v}; });
+	imgclean::processors::build_integral_image(image, ref_sq.data(), [](uint8_t v) { return uint64_t{v} * v; });
+
+	bool all_equal = true;
+	for (size_t y = 0; y <= static_cast<size_t>(image.height); ++y)
+	{
+		for (size_t x = 0; x < stride; ++x)
+		{
+			all_equal = all_equal && sum.at(x, y) == ref[y * stride + x];
+			all_equal = all_equal && sum_sq.at(x, y) == ref_sq[y * stride + x];
+		}
+	}
+	REQUIRE(all_equal);
+	REQUIRE(sum.box_sum(250, 250, 270, 262) == ref[263 * stride + 271] - ref[250 * stride + 271] -
+	                                                   ref[263 * stride + 250] + ref[250 * stride + 250]);
+}
+
+TEST_CASE("Integral images stay exact beyond 2^32", "[IntegralImage][IntegralImageProcessor][large]")
+{
+	// 17.6 MP of white paper -> the total exceeds the range of a 32-bit integral image
+	imgclean::GSImage image;
+	image.width  = 16;
+	image.height = 1100000;
+	image.pixels.assign(static_cast<size_t>(image.width) * image.height, 255);
+	// a black stripe near the bottom
+	const int stripe_begin = 1000000;
+	const int stripe_end   = stripe_begin + 4;
+	std::fill(image.pixels.begin() + static_cast<size_t>(stripe_begin) * image.width,
+	          image.pixels.begin() + static_cast<size_t>(stripe_end) * image.width, 0);
+
+	const auto sum = imgclean::processors::TiledIntegralImage::build(image, [](uint8_t v) { return v; });
+	const uint64_t expected_total = 255ull * (image.pixels.size() - 4ull * image.width);
+	REQUIRE(expected_total > UINT32_MAX);
+	REQUIRE(sum.total() == expected_total);
+	REQUIRE(sum.at(8, stripe_begin) == 255ull * 8 * stripe_begin);
+	REQUIRE(sum.box_sum(0, stripe_begin - 2, 15, stripe_end + 1) == 255ull * 16 * 4);
+
+	const imgclean::GSImage out = imgclean::processors::IntegralImageProcessor::apply(image);
+	bool stripe_only = true;
+	for (int y = 0; y < image.height; ++y)
+	{
+		const uint8_t expected = (y >= stripe_begin && y < stripe_end) ? 0 : 255;
+		for (int x = 0; x < image.width; ++x)
+			stripe_only = stripe_only && out.pixels[static_cast<size_t>(y) * image.width + x] == expected;
+	}
+	REQUIRE(stripe_only);
+}
+
+TEST_CASE("IntegralImageProcessor matches the reference implementation", "[IntegralImageProcessor]")
+{
+	const imgclean::GSImage image = make_document_image(301, 77, 5);
+	const int default_threads     = omp_get_max_threads();
+
+	omp_set_num_threads(1);
+	const imgclean::GSImage serial = imgclean::processors::IntegralImageProcessor::apply(image);
+	omp_set_num_threads(4);
+	const imgclean::GSImage parallel = imgclean::processors::IntegralImageProcessor::apply(image);
+	omp_set_num_threads(default_threads);
+
+	const imgclean::GSImage ref = threshold_reference(image, 7, 0.85f);
+	REQUIRE(serial.width == ref.width);
+	REQUIRE(serial.height == ref.height);
+	REQUIRE(serial.pixels == ref.pixels);
+	REQUIRE(parallel.pixels == ref.pixels);
+}
+
+TEST_CASE("IntegralImageProcessor engines agree", "[IntegralImageProcessor][BoxSumEngine]")
+{
+	using imgclean::processors::WindowEngine;
+	const imgclean::GSImage image    = make_document_image(257, 301, 13);
+	const imgclean::GSImage integral = imgclean::processors::IntegralImageProcessor::apply(image);
+	const imgclean::GSImage sliding  = imgclean::processors::IntegralImageProcessor::apply(
+		image, WindowEngine::SLIDING_WINDOW);
+	REQUIRE(sliding.width == integral.width);
+	REQUIRE(sliding.height == integral.height);
+	REQUIRE(sliding.pixels == integral.pixels);
+}
+
+TEST_CASE("IntegralImageProcessor honors the window size and threshold", "[IntegralImageProcessor]")
+{
+	using imgclean::processors::IntegralImageProcessor;
+	using imgclean::processors::WindowEngine;
+	// the second image is narrower than the largest specialized window
+	const imgclean::GSImage wide   = make_document_image(150, 90, 21);
+	const imgclean::GSImage narrow = make_document_image(40, 70, 22);
+
+	// 15, 31 and 63 run the specialized kernels, the others the generic path
+	for (const imgclean::GSImage* image : {&wide, &narrow})
+	{
+		for (int window : {1, 3, 15, 21, 31, 63, 201})
+		{
+			for (float t : {0.85f, 0.7f})
+			{
+				const imgclean::GSImage ref = threshold_reference(*image, window / 2, t);
+				for (WindowEngine engine : {WindowEngine::INTEGRAL_IMAGE, WindowEngine::SLIDING_WINDOW})
+				{
+					const auto out = IntegralImageProcessor::apply(*image, engine, window, t);
+					REQUIRE(out.pixels == ref.pixels);
+				}
+			}
+		}
+	}
+
+	REQUIRE(IntegralImageProcessor::apply(wide, WindowEngine::INTEGRAL_IMAGE, 14).empty());
+	REQUIRE(IntegralImageProcessor::apply(wide, WindowEngine::INTEGRAL_IMAGE, 0).empty());
+}
@@ -0,0 +1,116 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/NiblackProcessor.hpp"
+#include "imgclean/processors/SauvolaProcessor.hpp"
+#include "imgclean/processors/WolfProcessor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using imgclean::processors::WindowEngine;
+
+//! Brute force mean and stddev of every window, computed in double
+static void window_statistics(const imgclean::GSImage& image, int half_window, std::vector<double>& mean,
+                              std::vector<double>& stddev)
+{
+	const int w = image.width;
+	const int h = image.height;
+	mean.assign(image.pixels.size(), 0.0);
+	stddev.assign(image.pixels.size(), 0.0);
+	for (int y = 0; y < h; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			double acc = 0.0, acc_sq = 0.0, n = 0.0;
+			for (int v = std::max(0, y - half_window); v <= std::min(h - 1, y + half_window); ++v)
+			{
+				for (int u = std::max(0, x - half_window); u <= std::min(w - 1, x + half_window); ++u)
+				{
+					const double p = image.pixels[v * w + u];
+					acc += p;
+					acc_sq += p * p;
+					n += 1.0;
+				}
+			}
+			mean[y * w + x]   = acc / n;
+			stddev[y * w + x] = std::sqrt(std::max(0.0, acc_sq / n - mean[y * w + x] * mean[y * w + x]));
+		}
+	}
+}
+
+//! Counts the pixels where out disagrees with pixel < threshold(index)
+template <typename Threshold>
+static size_t count_mismatches(const imgclean::GSImage& image, const imgclean::GSImage& out, Threshold threshold)
+{
+	size_t mismatches = 0;
+	for (size_t i = 0; i < image.pixels.size(); ++i)
+	{
+		const uint8_t expected = image.pixels[i] < threshold(i) ? 0 : 255;
+		if (out.pixels[i] != expected) ++mismatches;
+	}
+	return mismatches;
+}
+
+TEST_CASE("Niblack, Sauvola and Wolf match the brute force thresholds", "[LocalThreshold]")
+{
+	const imgclean::GSImage image = make_document_image(123, 97, 31);
+
+	// 15 runs the specialized kernels, 21 the generic path
+	for (int window : {15, 21})
+	{
+		std::vector<double> mean, stddev;
+		window_statistics(image, window / 2, mean, stddev);
+		const double max_stddev = *std::max_element(stddev.begin(), stddev.end());
+		const double min_gray   = *std::min_element(image.pixels.begin(), image.pixels.end());
+
+		auto niblack = [&](size_t i) { return mean[i] - 0.2 * stddev[i]; };
+		auto sauvola = [&](size_t i) { return mean[i] * (1.0 + 0.5 * (stddev[i] / 128.0 - 1.0)); };
+		auto wolf    = [&](size_t i)
+		{
+			return mean[i] - 0.5 * (1.0 - stddev[i] / max_stddev) * (mean[i] - min_gray);
+		};
+
+		for (WindowEngine engine : {WindowEngine::INTEGRAL_IMAGE, WindowEngine::SLIDING_WINDOW})
+		{
+			// float rounding of the statistics may flip pixels that sit exactly on the threshold
+			const size_t tolerance = image.pixels.size() / 1000;
+			using namespace imgclean::processors;
+			const auto niblack_out = NiblackProcessor::apply(image, engine, window);
+			const auto sauvola_out = SauvolaProcessor::apply(image, engine, window);
+			const auto wolf_out    = WolfProcessor::apply(image, engine, window);
+			REQUIRE(count_mismatches(image, niblack_out, niblack) <= tolerance);
+			REQUIRE(count_mismatches(image, sauvola_out, sauvola) <= tolerance);
+			REQUIRE(count_mismatches(image, wolf_out, wolf) <= tolerance);
+		}
+	}
+}
+
+TEST_CASE("Local threshold engines agree", "[LocalThreshold][BoxSumEngine]")
+{
+	using namespace imgclean::processors;
+	const imgclean::GSImage image = make_document_image(211, 260, 5);
+
+	REQUIRE(NiblackProcessor::apply_binary(image, WindowEngine::INTEGRAL_IMAGE).words ==
+	        NiblackProcessor::apply_binary(image, WindowEngine::SLIDING_WINDOW).words);
+	REQUIRE(SauvolaProcessor::apply_binary(image, WindowEngine::INTEGRAL_IMAGE, 31).words ==
+	        SauvolaProcessor::apply_binary(image, WindowEngine::SLIDING_WINDOW, 31).words);
+	REQUIRE(WolfProcessor::apply_binary(image, WindowEngine::INTEGRAL_IMAGE, 25).words ==
+	        WolfProcessor::apply_binary(image, WindowEngine::SLIDING_WINDOW, 25).words);
+}
+
+TEST_CASE("Local thresholds of degenerate images", "[LocalThreshold]")
+{
+	using namespace imgclean::processors;
+	REQUIRE(SauvolaProcessor::apply(imgclean::GSImage()).empty());
+	REQUIRE(WolfProcessor::apply(make_document_image(10, 10, 1), WindowEngine::INTEGRAL_IMAGE, 4).empty());
+
+	// a flat page has no ink
+	imgclean::GSImage flat = make_document_image(40, 30, 2);
+	std::fill(flat.pixels.begin(), flat.pixels.end(), 200);
+	for (const imgclean::GSImage& out :
+	     {NiblackProcessor::apply(flat), SauvolaProcessor::apply(flat), WolfProcessor::apply(flat)})
+	{
+		REQUIRE(std::all_of(out.pixels.begin(), out.pixels.end(), [](uint8_t v) { return v == 255; }));
+	}
+}
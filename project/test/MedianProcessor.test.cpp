@@ -0,0 +1,61 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/MedianProcessor.hpp"
+#include <algorithm>
+#include <vector>
+
+using imgclean::processors::MedianProcessor;
+
+//! Brute force median of the window around every pixel, borders replicated
+static imgclean::GSImage brute_force_median(const imgclean::GSImage& image, int window_size)
+{
+	const int half                 = window_size / 2;
+	imgclean::GSImage output_image = image;
+	std::vector<uint8_t> values;
+	for (int y = 0; y < image.height; ++y)
+	{
+		for (int x = 0; x < image.width; ++x)
+		{
+			values.clear();
+			for (int v = y - half; v <= y + half; ++v)
+			{
+				for (int u = x - half; u <= x + half; ++u)
+				{
+					const int cu = std::clamp(u, 0, image.width - 1);
+					const int cv = std::clamp(v, 0, image.height - 1);
+					values.push_back(image.pixels[cv * image.width + cu]);
+				}
+			}
+			std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+			output_image.pixels[y * image.width + x] = values[values.size() / 2];
+		}
+	}
+	return output_image;
+}
+
+TEST_CASE("Constant-time median matches brute force", "[MedianProcessor]")
+{
+	// several column strips, windows smaller and larger than the image height
+	const imgclean::GSImage image = make_document_image(600, 41, 9);
+	for (int window : {1, 3, 5, 15, 51})
+	{
+		INFO("window " << window);
+		REQUIRE(MedianProcessor::apply(image, window).pixels == brute_force_median(image, window).pixels);
+	}
+
+	REQUIRE(MedianProcessor::apply(image, 4).empty());
+	REQUIRE(MedianProcessor::apply(image, MedianProcessor::max_window_size + 2).empty());
+	REQUIRE(MedianProcessor::apply(imgclean::GSImage()).empty());
+}
+
+TEST_CASE("Median removes salt and pepper noise", "[MedianProcessor]")
+{
+	imgclean::GSImage image = make_document_image(64, 64, 2);
+	std::fill(image.pixels.begin(), image.pixels.end(), 200);
+	image.pixels[10 * 64 + 10] = 0;
+	image.pixels[40 * 64 + 33] = 255;
+	const imgclean::GSImage output_image = MedianProcessor::apply(image, 3);
+	const auto& pixels = output_image.pixels;
+	REQUIRE(std::all_of(pixels.begin(), pixels.end(), [](uint8_t v) { return v == 200; }));
+}
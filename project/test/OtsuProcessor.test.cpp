@@ -0,0 +1,85 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/OtsuProcessor.hpp"
+#include <algorithm>
+
+using imgclean::processors::OtsuProcessor;
+
+TEST_CASE("Otsu histogram counts every pixel", "[OtsuProcessor]")
+{
+	// the odd size leaves a tail after the 8-pixel steps
+	const imgclean::GSImage image = make_document_image(157, 93, 6);
+	OtsuProcessor::Histogram expected{};
+	for (uint8_t v : image.pixels)
+	{
+		++expected[v];
+	}
+	REQUIRE(OtsuProcessor::histogram(image) == expected);
+}
+
+TEST_CASE("Otsu threshold maximizes the between-class variance", "[OtsuProcessor]")
+{
+	const OtsuProcessor::Histogram hist = OtsuProcessor::histogram(make_document_image(200, 150, 11));
+
+	// brute force over all splits, class means computed directly
+	double best_between = 0.0;
+	auto between        = [&](int t)
+	{
+		double w_b = 0.0, w_f = 0.0, s_b = 0.0, s_f = 0.0;
+		for (int v = 0; v < 256; ++v)
+		{
+			(v < t ? w_b : w_f) += static_cast<double>(hist[v]);
+			(v < t ? s_b : s_f) += static_cast<double>(v) * hist[v];
+		}
+		if (w_b == 0.0 || w_f == 0.0) return 0.0;
+		return w_b * w_f * (s_b / w_b - s_f / w_f) * (s_b / w_b - s_f / w_f);
+	};
+	for (int t = 1; t < 256; ++t)
+	{
+		best_between = std::max(best_between, between(t));
+	}
+
+	const int t = OtsuProcessor::threshold(hist);
+	REQUIRE(t > 0);
+	REQUIRE(between(t) == Approx(best_between).epsilon(1e-12));
+}
+
+TEST_CASE("Otsu separates a bimodal page", "[OtsuProcessor]")
+{
+	imgclean::GSImage image = make_document_image(130, 70, 3);
+	for (size_t i = 0; i < image.pixels.size(); ++i)
+	{
+		image.pixels[i] = (i % 7 == 0) ? 40 + i % 5 : 200 + i % 9;
+	}
+
+	const int t = OtsuProcessor::threshold(OtsuProcessor::histogram(image));
+	REQUIRE(t > 44);
+	REQUIRE(t <= 200);
+
+	const imgclean::GSImage gray     = OtsuProcessor::apply(image);
+	const imgclean::BinaryImage bits = OtsuProcessor::apply_binary(image);
+	bool all_equal                   = true;
+	for (int y = 0; y < image.height; ++y)
+	{
+		for (int x = 0; x < image.width; ++x)
+		{
+			const size_t i = static_cast<size_t>(y) * image.width + x;
+			const bool ink = i % 7 == 0;
+			all_equal &= gray.pixels[i] == (ink ? 0 : 255);
+			all_equal &= bits.get(x, y) == ink;
+		}
+	}
+	REQUIRE(all_equal);
+}
+
+TEST_CASE("Otsu of a flat page has no ink", "[OtsuProcessor]")
+{
+	imgclean::GSImage image = make_document_image(70, 5, 1);
+	std::fill(image.pixels.begin(), image.pixels.end(), 128);
+
+	REQUIRE(OtsuProcessor::threshold(OtsuProcessor::histogram(image)) == 0);
+	const imgclean::BinaryImage bits = OtsuProcessor::apply_binary(image);
+	REQUIRE(std::all_of(bits.words.begin(), bits.words.end(), [](uint64_t w) { return w == 0; }));
+	REQUIRE(OtsuProcessor::apply(imgclean::GSImage()).empty());
+}
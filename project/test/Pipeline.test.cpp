@@ -0,0 +1,145 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/Pipeline.hpp"
+#include "imgclean/processors/ClaheProcessor.hpp"
+#include "imgclean/processors/DespeckleProcessor.hpp"
+#include "imgclean/processors/GaussianProcessor.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/IntegralImageProcessor.hpp"
+#include "imgclean/processors/MedianProcessor.hpp"
+#include "imgclean/processors/OtsuProcessor.hpp"
+#include "imgclean/processors/SauvolaProcessor.hpp"
+#include <string>
+
+using imgclean::Pipeline;
+using imgclean::PixelType;
+
+//! RGB page with equal channels
+static imgclean::PPMImage make_rgb_document(int width, int height)
+{
+	const imgclean::GSImage gray = make_document_image(width, height, 7);
+	imgclean::PPMImage image;
+	image.width  = width;
+	image.height = height;
+	for (uint8_t value : gray.pixels)
+	{
+		image.pixels.insert(image.pixels.end(), 3, value);
+	}
+	return image;
+}
+
+TEST_CASE("Pipeline parses stages and arguments", "[Pipeline]")
+{
+	Pipeline pipeline;
+
+	REQUIRE(Pipeline::parse("gray|sauvola:w=31,k=0.3", pipeline));
+	REQUIRE(pipeline.describe() == "gray|sauvola:w=31,k=0.3");
+
+	// positional arguments in declared order, defaults for the rest
+	REQUIRE(Pipeline::parse(" gray | integral:21 ", pipeline));
+	REQUIRE(pipeline.describe() == "gray|integral:w=21,t=0.85,g=1");
+
+	// a trailing number is the first positional argument
+	REQUIRE(Pipeline::parse("sauvola31", pipeline));
+	REQUIRE(pipeline.describe() == "gray|sauvola:w=31,k=0.5");
+	REQUIRE(Pipeline::parse("median3|sauvola", pipeline));
+	REQUIRE(pipeline.describe() == "gray|median:w=3|sauvola:w=15,k=0.5");
+}
+
+TEST_CASE("Pipeline inserts conversions and plans slots", "[Pipeline]")
+{
+	Pipeline pipeline;
+	REQUIRE(Pipeline::parse("otsu|niblack", pipeline));
+	REQUIRE(pipeline.describe() == "gray|otsu|expand|niblack:w=15,k=-0.2");
+
+	const auto& stages = pipeline.stages();
+	REQUIRE(stages.front().input == PixelType::RGB16);
+	REQUIRE(stages.back().output == PixelType::BINARY);
+	for (size_t i = 0; i < stages.size(); ++i)
+	{
+		if (i > 0) REQUIRE(stages[i].input_slot == stages[i - 1].output_slot);
+		// a stage never overwrites its own input
+		if (stages[i].input == stages[i].output) REQUIRE(stages[i].input_slot != stages[i].output_slot);
+	}
+}
+
+TEST_CASE("Pipeline rejects invalid descriptions", "[Pipeline]")
+{
+	Pipeline pipeline;
+	for (const std::string spec : {"", "gray||otsu", "unknown", "sauvola:w=14", "sauvola:w=0", "sauvola:x=3",
+	                               "sauvola:w=abc", "sauvola:3,0.5,1", "fixed:t=1.5", "fixed:300", "expand",
+	                               "otsu|gray"})
+	{
+		INFO(spec);
+		REQUIRE_FALSE(Pipeline::parse(spec, pipeline));
+	}
+}
+
+TEST_CASE("Pipeline runs like the processors", "[Pipeline]")
+{
+	using namespace imgclean::processors;
+	const imgclean::PPMImage input = make_rgb_document(157, 83);
+	const imgclean::GSImage gray   = HelperProcessor::rgb_to_linear_grayscale(input);
+
+	Pipeline pipeline;
+	imgclean::GSImage output;
+
+	REQUIRE(Pipeline::parse("sauvola:w=21,k=0.3", pipeline));
+	REQUIRE(pipeline.run(input, output));
+	REQUIRE(output.pixels == SauvolaProcessor::apply(gray, WindowEngine::INTEGRAL_IMAGE, 21, 0.3f).pixels);
+
+	// buffers of the previous run are reused
+	REQUIRE(pipeline.run(input, output));
+	REQUIRE(output.pixels == SauvolaProcessor::apply(gray, WindowEngine::INTEGRAL_IMAGE, 21, 0.3f).pixels);
+
+	REQUIRE(Pipeline::parse("median3|otsu|expand", pipeline));
+	REQUIRE(pipeline.run(input, output));
+	REQUIRE(output.pixels == OtsuProcessor::apply(MedianProcessor::apply(gray, 3)).pixels);
+
+	REQUIRE(Pipeline::parse("clahe:4,3|otsu|expand", pipeline));
+	REQUIRE(pipeline.run(input, output));
+	REQUIRE(output.pixels == OtsuProcessor::apply(ClaheProcessor::apply(gray, 4, 3.0f)).pixels);
+
+	REQUIRE(Pipeline::parse("gaussian:2|integral", pipeline));
+	REQUIRE(pipeline.run(input, output));
+	REQUIRE(output.pixels == IntegralImageProcessor::apply(GaussianProcessor::apply(gray, 2.0f)).pixels);
+
+	REQUIRE(Pipeline::parse("otsu|despeckle:8", pipeline));
+	REQUIRE(pipeline.run(input, output));
+	const imgclean::BinaryImage despeckled = DespeckleProcessor::apply(OtsuProcessor::apply_binary(gray), 8);
+	REQUIRE(output.pixels == HelperProcessor::binary_to_grayscale(despeckled).pixels);
+
+	REQUIRE(Pipeline::parse("otsu|expand", pipeline));
+	REQUIRE(pipeline.run(input, output));
+	REQUIRE(output.pixels == OtsuProcessor::apply(gray).pixels);
+
+	REQUIRE_FALSE(pipeline.run(imgclean::PPMImage(), output));
+}
+
+TEST_CASE("Fused pipelines match separate stages", "[Pipeline][FusedThreshold]")
+{
+	const imgclean::PPMImage input = make_rgb_document(211, 300);
+
+	for (const std::string spec :
+	     {"integral:31", "integral:31,0.85,4", "niblack", "sauvola:w=21,k=0.3", "otsu|expand|sauvola"})
+	{
+		INFO(spec);
+		Pipeline fused, separate;
+		REQUIRE(Pipeline::parse(spec, fused, true));
+		REQUIRE(Pipeline::parse(spec, separate));
+		REQUIRE(fused.describe() == separate.describe());
+		REQUIRE_FALSE(separate.stages().front().fused);
+
+		imgclean::GSImage fused_output, separate_output;
+		REQUIRE(fused.run(input, fused_output));
+		REQUIRE(separate.run(input, separate_output));
+		REQUIRE(fused_output.pixels == separate_output.pixels);
+	}
+
+	// only a stage right after "gray" reads the RGB input
+	Pipeline pipeline;
+	REQUIRE(Pipeline::parse("sauvola|expand|sauvola", pipeline, true));
+	REQUIRE(pipeline.stages()[0].fused);
+	REQUIRE_FALSE(pipeline.stages()[2].fused);
+}
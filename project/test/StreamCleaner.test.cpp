@@ -0,0 +1,167 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/StreamCleaner.hpp"
+#include "imgclean/processors/HelperProcessor.hpp"
+#include "imgclean/processors/IntegralImageProcessor.hpp"
+#include "imgclean/processors/NiblackProcessor.hpp"
+#include "imgclean/processors/SauvolaProcessor.hpp"
+#include <algorithm>
+#include <vector>
+
+using imgclean::StreamCleaner;
+using imgclean::processors::WindowEngine;
+
+//! Collects the emitted rows into a page and checks that they arrive in order
+struct RowCollector
+{
+	imgclean::BinaryImage page;
+	int next_row = 0;
+
+	StreamCleaner::RowSink sink()
+	{
+		return [this](int y, const uint64_t* row)
+		{
+			REQUIRE(y == next_row);
+			std::copy(row, row + page.words_per_row, page.row(y));
+			++next_row;
+		};
+	}
+};
+
+TEST_CASE("StreamCleaner matches the whole-page processors", "[StreamCleaner]")
+{
+	// width and height not divisible by the word size, the window or the number of rows per push
+	const imgclean::GSImage gray = make_document_image(203, 157);
+	imgclean::CleanOptions options;
+
+	for (int window : {1, 15, 63, 45})
+	{
+		options.window_size = window;
+		const std::vector<std::pair<std::string, imgclean::BinaryImage>> expected = {
+			{"integral", imgclean::processors::IntegralImageProcessor::apply_binary(gray, WindowEngine::SLIDING_WINDOW,
+		                                                                            window, options.threshold)},
+			{"niblack", imgclean::processors::NiblackProcessor::apply_binary(gray, WindowEngine::SLIDING_WINDOW,
+		                                                                     window)},
+			{"sauvola", imgclean::processors::SauvolaProcessor::apply_binary(gray, WindowEngine::SLIDING_WINDOW,
+		                                                                     window)},
+		};
+		for (const auto& [approach, page] : expected)
+		{
+			RowCollector collector;
+			collector.page.resize(gray.width, gray.height);
+			StreamCleaner cleaner;
+			REQUIRE(StreamCleaner::create(approach, options, gray.width, collector.sink(), cleaner));
+			REQUIRE(cleaner.latency() == window / 2);
+
+			// row y is emitted as soon as row y + latency arrived
+			for (int y = 0; y < gray.height; y += 10)
+			{
+				const int count = std::min(10, gray.height - y);
+				cleaner.push_rows(gray.pixels.data() + static_cast<size_t>(y) * gray.width, count);
+				REQUIRE(collector.next_row == std::max(0, y + count - cleaner.latency()));
+			}
+			cleaner.finish();
+			REQUIRE(collector.next_row == gray.height);
+			REQUIRE(collector.page.words == page.words);
+
+			// the next page starts at row 0
+			collector.next_row = 0;
+			cleaner.push_rows(gray.pixels.data(), gray.height);
+			cleaner.finish();
+			REQUIRE(collector.page.words == page.words);
+		}
+	}
+}
+
+TEST_CASE("StreamCleaner converts RGB rows", "[StreamCleaner]")
+{
+	const imgclean::GSImage document = make_document_image(130, 90, 3);
+	imgclean::PPMImage rgb;
+	rgb.width  = document.width;
+	rgb.height = document.height;
+	for (size_t i = 0; i < document.pixels.size(); ++i)
+	{
+		const uint16_t value = document.pixels[i];
+		rgb.pixels.insert(rgb.pixels.end(), {value, static_cast<uint16_t>(value / 2), static_cast<uint16_t>(value)});
+	}
+
+	// with the maximum luma of the page the result equals the pipeline on the whole page
+	imgclean::Pipeline pipeline;
+	REQUIRE(imgclean::Pipeline::parse("gray|sauvola:w=31", pipeline));
+	imgclean::GSImage expected;
+	REQUIRE(pipeline.run(rgb, expected));
+
+	RowCollector collector;
+	collector.page.resize(rgb.width, rgb.height);
+	StreamCleaner cleaner;
+	REQUIRE(StreamCleaner::create(pipeline, rgb.width, collector.sink(), cleaner));
+	cleaner.push_rows(rgb.pixels.data(), rgb.height, imgclean::processors::HelperProcessor::max_luma(rgb));
+	cleaner.finish();
+	REQUIRE(imgclean::processors::HelperProcessor::binary_to_grayscale(collector.page).pixels == expected.pixels);
+}
+
+TEST_CASE("StreamCleaner clamps samples brighter than max_luma", "[StreamCleaner]")
+{
+	// ink at 40 on paper at 250, the white level is set below the paper
+	const int width = 70;
+	std::vector<uint16_t> rgb;
+	for (int y = 0; y < 40; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const uint16_t value = (y % 10 < 3 && x % 7 < 2) ? 40 : 250;
+			rgb.insert(rgb.end(), {value, value, value});
+		}
+	}
+
+	std::vector<uint8_t> gray(width);
+	imgclean::processors::HelperProcessor::linear_grayscale_row(rgb.data(), width, 200, gray.data());
+	REQUIRE(gray[0] == 51);
+	REQUIRE(gray[2] == 255);
+
+	RowCollector collector;
+	collector.page.resize(width, 40);
+	StreamCleaner cleaner;
+	imgclean::Pipeline pipeline;
+	REQUIRE(imgclean::Pipeline::parse("gray|sauvola:w=15", pipeline));
+	REQUIRE(StreamCleaner::create(pipeline, width, collector.sink(), cleaner));
+	cleaner.push_rows(rgb.data(), 40, 200);
+	cleaner.finish();
+
+	// the paper stays background, the strokes stay ink
+	bool as_drawn = true;
+	for (int y = 0; y < 40; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			as_drawn &= collector.page.get(x, y) == (y % 10 < 3 && x % 7 < 2);
+		}
+	}
+	REQUIRE(as_drawn);
+}
+
+TEST_CASE("StreamCleaner rejects stages that need the whole page", "[StreamCleaner]")
+{
+	StreamCleaner cleaner;
+	const imgclean::CleanOptions options;
+	auto sink = [](int, const uint64_t*) {};
+	REQUIRE(!StreamCleaner::create("otsu", options, 100, sink, cleaner));
+	REQUIRE(!StreamCleaner::create("wolf", options, 100, sink, cleaner));
+	REQUIRE(!StreamCleaner::create("sauvola", options, 0, sink, cleaner));
+
+	imgclean::Pipeline pipeline;
+	REQUIRE(imgclean::Pipeline::parse("median3|sauvola", pipeline));
+	REQUIRE(!StreamCleaner::create(pipeline, 100, sink, cleaner));
+	REQUIRE(imgclean::Pipeline::parse("sauvola|despeckle", pipeline));
+	REQUIRE(!StreamCleaner::create(pipeline, 100, sink, cleaner));
+	REQUIRE(imgclean::Pipeline::parse("niblack:w=21", pipeline));
+	REQUIRE(StreamCleaner::create(pipeline, 100, sink, cleaner));
+	REQUIRE(cleaner.latency() == 10);
+
+	// the grid approximation needs the whole page
+	REQUIRE(imgclean::Pipeline::parse("integral:g=2", pipeline));
+	REQUIRE(!StreamCleaner::create(pipeline, 100, sink, cleaner));
+	REQUIRE(imgclean::Pipeline::parse("integral:g=1", pipeline));
+	REQUIRE(StreamCleaner::create(pipeline, 100, sink, cleaner));
+}
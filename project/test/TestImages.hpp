@@ -0,0 +1,40 @@
+#ifndef IMGCLEAN_TEST_TESTIMAGES_HPP
+#define IMGCLEAN_TEST_TESTIMAGES_HPP
+
+#include "imgclean/GSImage.hpp"
+#include <cstddef>
+#include <cstdint>
+
+//! Deterministic synthetic "scanned page": shaded paper, dark text-like strokes and noise
+inline imgclean::GSImage make_document_image(int width, int height, uint32_t seed = 1)
+{
+	imgclean::GSImage image;
+	image.width  = width;
+	image.height = height;
+	image.pixels.resize(static_cast<size_t>(width) * height);
+
+	uint32_t state = seed;
+	//! Small LCG so that results do not depend on the standard library implementation
+	auto next = [&state]()
+	{
+		state = state * 1664525u + 1013904223u;
+		return state >> 16;
+	};
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			// illumination gradient from top-left to bottom-right
+			int value = 170 + (60 * x) / width + (20 * y) / height;
+			// text lines of short strokes
+			if ((y % 24) >= 6 && (y % 24) < 18 && (x % 9) < 3 && ((x / 9 + y / 24) % 5) != 0) value = 40;
+			value += static_cast<int>(next() % 21) - 10;
+			image.pixels[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(
+				value < 0 ? 0 : (value > 255 ? 255 : value));
+		}
+	}
+	return image;
+}
+
+#endif // IMGCLEAN_TEST_TESTIMAGES_HPP
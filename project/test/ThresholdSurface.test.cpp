@@ -0,0 +1,93 @@
+#include "catch.hpp"
+
+#include "TestImages.hpp"
+#include "imgclean/processors/ImageBinarizationProcessor.hpp"
+#include "imgclean/processors/IntegralImageProcessor.hpp"
+#include "imgclean/processors/ThresholdSurface.hpp"
+#include <bit>
+
+using namespace imgclean::processors;
+
+//! Number of pixels that differ between two binary images of the same size
+static size_t count_differences(const imgclean::BinaryImage& a, const imgclean::BinaryImage& b)
+{
+	size_t differences = 0;
+	for (size_t k = 0; k < a.words.size(); ++k)
+	{
+		differences += std::popcount(a.words[k] ^ b.words[k]);
+	}
+	return differences;
+}
+
+TEST_CASE("Threshold surface grid covers the image", "[ThresholdSurface]")
+{
+	const ThresholdSurface surface(10, 9, 4);
+	REQUIRE(surface.columns() == 4);
+	REQUIRE(surface.rows() == 3);
+	REQUIRE(surface.x(2) == 8);
+	REQUIRE(surface.x(3) == 9);
+	REQUIRE(surface.y(2) == 8);
+
+	REQUIRE(ThresholdSurface(1, 1, 8).columns() == 1);
+	REQUIRE(ThresholdSurface(5, 1, 1).columns() == 5);
+}
+
+TEST_CASE("Threshold surface interpolates bilinearly", "[ThresholdSurface]")
+{
+	// threshold rising from 0 to 160 along x, the row becomes ink where the pixel is below it
+	ThresholdSurface surface(9, 3, 8);
+	surface.at(0, 0) = surface.at(0, 1) = 0.0f;
+	surface.at(1, 0) = surface.at(1, 1) = 160.0f;
+
+	imgclean::GSImage image;
+	image.width  = 9;
+	image.height = 3;
+	image.pixels.assign(27, 100);
+
+	const imgclean::BinaryImage binary = surface.binarize(image);
+	for (int x = 0; x < 9; ++x)
+	{
+		// threshold 20 * x
+		REQUIRE(binary.get(x, 1) == (100 < 20 * x));
+	}
+}
+
+TEST_CASE("Approximate thresholds match the exact ones", "[ThresholdSurface]")
+{
+	const imgclean::GSImage image = make_document_image(301, 203, 17);
+	const size_t pixels           = image.pixels.size();
+
+	for (WindowEngine engine : {WindowEngine::INTEGRAL_IMAGE, WindowEngine::SLIDING_WINDOW})
+	{
+		for (int window : {15, 41})
+		{
+			const auto exact_integral = IntegralImageProcessor::apply_binary(image, engine, window, 0.85f);
+			const auto exact_adaptive = ImageBinarizationProcessor::apply_binary(image, engine, window);
+
+			// factor 1 samples every pixel
+			REQUIRE(IntegralImageProcessor::apply_approximate(image, engine, window, 0.85f, 1).words ==
+			        exact_integral.words);
+			REQUIRE(ImageBinarizationProcessor::apply_approximate(image, engine, window, 1).words ==
+			        exact_adaptive.words);
+
+			// the samples are exact, so both engines build the same surface
+			const bool sliding = engine == WindowEngine::SLIDING_WINDOW;
+			const auto other   = sliding ? WindowEngine::INTEGRAL_IMAGE : WindowEngine::SLIDING_WINDOW;
+			for (int factor : {2, 4, 8})
+			{
+				INFO("window " << window << ", factor " << factor);
+				using Integral      = IntegralImageProcessor;
+				using Adaptive      = ImageBinarizationProcessor;
+				const auto integral = Integral::apply_approximate(image, engine, window, 0.85f, factor);
+				const auto adaptive = Adaptive::apply_approximate(image, engine, window, factor);
+				REQUIRE(count_differences(integral, exact_integral) < pixels / 50);
+				REQUIRE(count_differences(adaptive, exact_adaptive) < pixels / 50);
+				REQUIRE(Integral::apply_approximate(image, other, window, 0.85f, factor).words ==
+				        integral.words);
+			}
+		}
+	}
+
+	REQUIRE(IntegralImageProcessor::apply_approximate(image, WindowEngine::SLIDING_WINDOW, 15, 0.85f, 0).empty());
+	REQUIRE(ImageBinarizationProcessor::apply_approximate(image, WindowEngine::SLIDING_WINDOW, 15, 17).empty());
+}